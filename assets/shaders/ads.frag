@@ -1,8 +1,8 @@
 #version 420 core
 
 uniform sampler2D baseColorTexture;
-uniform vec3 lightPosition;
-uniform vec3 eye;
+
+#include "frameuniforms.glsl"
 
 in vec2 vs_texcoord;
 in vec3 vs_position;
@@ -3,12 +3,10 @@
 layout(location=0) in vec3 position;
 layout(location=1) in vec2 texcoord;
 layout(location=2) in vec3 normal;
+layout(location=3) in mat4 modelMatrix; // per instance
+layout(location=7) in mat3 normalMatrix; // per instance
 
-uniform mat4 modelViewProjection;
-uniform mat3 normalMatrix;
-uniform mat4 modelViewMatrix;
-uniform mat4 viewMatrix;
-uniform mat4 modelMatrix;
+#include "frameuniforms.glsl"
 
 out vec2 vs_texcoord;
 out vec3 vs_position;
@@ -16,8 +14,9 @@ out vec3 vs_normal;
 
 void main(void)
 {
-    vs_position = vec3(viewMatrix * modelMatrix * vec4(position, 1.0));
+    vec4 viewPosition = viewMatrix * modelMatrix * vec4(position, 1.0);
+    vs_position = vec3(viewPosition);
     vs_normal = normalMatrix * normal;
     vs_texcoord = texcoord;
-    gl_Position = modelViewProjection * vec4(position, 1.0);
+    gl_Position = projectionMatrix * viewPosition;
 }
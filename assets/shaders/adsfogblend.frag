@@ -1,10 +1,9 @@
 #version 420 core
 
 uniform sampler2D baseColorTexture;
-uniform vec3 lightPosition;
-uniform vec3 eye;
-uniform vec2 fogDistance; // near, far
-uniform vec4 fogColor;
+
+#include "frameuniforms.glsl"
+
 uniform vec4 blendColor;
 uniform float mixFactor;
 
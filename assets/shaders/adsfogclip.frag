@@ -1,11 +1,8 @@
 #version 420 core
 
 uniform sampler2D baseColorTexture;
-uniform vec3 lightPosition;
-uniform vec3 eye;
-uniform vec2 fogDistance; // near, far
-uniform vec4 fogColor;
-uniform vec4 clipPlane;
+
+#include "frameuniforms.glsl"
 
 in vec2 vs_texcoord;
 in vec3 vs_position;
@@ -0,0 +1,45 @@
+#version 420 core
+
+// particle vertices pulled from the particle buffer, three RGB32F texels per particle:
+// position, velocity, (size, alpha)
+layout(binding=1) uniform samplerBuffer particleData;
+uniform int baseInstance;
+
+#include "frameuniforms.glsl"
+
+uniform mat4 modelMatrix;
+uniform mat3 normalMatrix;
+
+out SpriteVertex {
+    vec2 texCoord;
+    float alpha;
+} vs_out;
+
+void main(void)
+{
+    int texel = 3 * (baseInstance + gl_InstanceID);
+    vec3 position = texelFetch(particleData, texel).xyz;
+    vec3 velocity = texelFetch(particleData, texel + 1).xyz;
+    vec3 sizeAlpha = texelFetch(particleData, texel + 2).xyz;
+
+    vec3 worldPosition = vec3(modelMatrix * vec4(position, 1));
+    vec3 worldVelocity = normalMatrix * velocity;
+
+    vec2 size = sizeAlpha.xy;
+
+    vec3 velVec = normalize(worldVelocity);
+    vec3 eyeVec = eye - worldPosition;
+    vec3 eyeOnVelVecPlane = eye - dot(eyeVec, velVec) * velVec;
+    vec3 projectedEyeVec = eyeOnVelVecPlane - worldPosition;
+    vec3 sideVec = normalize(cross(projectedEyeVec, velVec));
+
+    // triangle strip corners: (0, 0), (1, 0), (0, 1), (1, 1)
+    vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+
+    vec3 spriteVert = worldPosition - sideVec * 0.5 * size.x + velVec * 0.5 * size.y;
+    spriteVert += sideVec * size.x * corner.x + velVec * size.y * corner.y;
+
+    gl_Position = projectionMatrix * viewMatrix * vec4(spriteVert, 1);
+    vs_out.texCoord = corner;
+    vs_out.alpha = sizeAlpha.z;
+}
@@ -1,10 +1,11 @@
 #version 420 core
 
 layout(location=0) in vec3 position;
+layout(location=3) in mat4 modelMatrix; // per instance
 
-uniform mat4 modelViewProjection;
+#include "frameuniforms.glsl"
 
 void main(void)
 {
-    gl_Position = modelViewProjection * vec4(position, 1.0);
+    gl_Position = projectionMatrix * viewMatrix * modelMatrix * vec4(position, 1.0);
 }
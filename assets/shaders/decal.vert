@@ -2,13 +2,14 @@
 
 layout(location=0) in vec3 position;
 layout(location=1) in vec2 texcoord;
+layout(location=3) in mat4 modelMatrix; // per instance
 
-uniform mat4 modelViewProjection;
+#include "frameuniforms.glsl"
 
 out vec2 vs_texcoord;
 
 void main(void)
 {
     vs_texcoord = texcoord;
-    gl_Position = modelViewProjection * vec4(position, 1.0);
+    gl_Position = projectionMatrix * viewMatrix * modelMatrix * vec4(position, 1.0);
 }
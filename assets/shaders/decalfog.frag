@@ -1,8 +1,8 @@
 #version 420 core
 
 uniform sampler2D baseColorTexture;
-uniform vec2 fogDistance; // near, far
-uniform vec4 fogColor;
+
+#include "frameuniforms.glsl"
 
 in vec2 vs_texcoord;
 in float vs_distance;
@@ -2,9 +2,9 @@
 
 layout(location=0) in vec3 position;
 layout(location=1) in vec2 texcoord;
+layout(location=3) in mat4 modelMatrix; // per instance
 
-uniform mat4 modelViewProjection;
-uniform vec3 eye;
+#include "frameuniforms.glsl"
 
 out vec2 vs_texcoord;
 out float vs_distance;
@@ -13,5 +13,5 @@ void main(void)
 {
     vs_texcoord = texcoord;
     vs_distance = distance(position, eye);
-    gl_Position = modelViewProjection * vec4(position, 1.0);
+    gl_Position = projectionMatrix * viewMatrix * modelMatrix * vec4(position, 1.0);
 }
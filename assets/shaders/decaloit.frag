@@ -0,0 +1,12 @@
+#version 420 core
+
+uniform sampler2D baseColorTexture;
+
+in vec2 vs_texcoord;
+
+#include "oit.glsl"
+
+void main(void)
+{
+    writeTransparent(texture(baseColorTexture, vs_texcoord));
+}
@@ -0,0 +1,10 @@
+// per-frame state shared by all programs, laid out as FrameUniformBlock in shadermanager.cpp
+layout(std140, binding=0) uniform FrameUniforms {
+    mat4 viewMatrix;
+    mat4 projectionMatrix;
+    vec3 eye;
+    vec3 lightPosition;
+    vec4 fogColor;
+    vec2 fogDistance; // near, far
+    vec4 clipPlane;
+};
@@ -0,0 +1,12 @@
+#version 420 core
+
+// fullscreen triangle, no vertex attributes
+
+out vec2 vs_texcoord;
+
+void main(void)
+{
+    vec2 position = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    vs_texcoord = position;
+    gl_Position = vec4(2.0 * position - 1.0, 0.0, 1.0);
+}
@@ -0,0 +1,11 @@
+// weighted blended order-independent transparency (McGuire and Bavoil 2013), written to the targets
+// of TransparencyPass
+layout(location=0) out vec4 accumulation;
+layout(location=1) out float revealage;
+
+void writeTransparent(vec4 color)
+{
+    float weight = clamp(pow(min(1.0, color.a * 10.0) + 0.01, 3.0) * 1e8 * pow(1.0 - gl_FragCoord.z * 0.9, 3.0), 1e-2, 3e3);
+    accumulation = vec4(color.rgb * color.a, color.a) * weight;
+    revealage = color.a;
+}
@@ -0,0 +1,19 @@
+#version 420 core
+
+layout(binding=0) uniform sampler2D accumulationTexture;
+layout(binding=1) uniform sampler2D revealageTexture;
+
+in vec2 vs_texcoord;
+
+out vec4 fragColor;
+
+void main(void)
+{
+    float revealage = texture(revealageTexture, vs_texcoord).r;
+    if (revealage == 1.0)
+        discard;
+    vec4 accumulation = texture(accumulationTexture, vs_texcoord);
+    vec3 averageColor = accumulation.rgb / clamp(accumulation.a, 1e-4, 5e4);
+    // blended with GL_ONE_MINUS_SRC_ALPHA, GL_SRC_ALPHA
+    fragColor = vec4(averageColor, revealage);
+}
@@ -0,0 +1,110 @@
+#version 420 core
+
+// strips laid along the path (the track, hold note bodies), one per instance and drawn as a
+// triangle strip: a pair of vertices at each path part between the ends, plus four pairs for each
+// end, which get their corners cut off by the bevel.
+//
+// path parts pulled from a ring in a buffer texture, two RGBA32F texels per part:
+// (center, distance), orientation quaternion
+layout(binding=1) uniform samplerBuffer pathParts;
+uniform int pathFirst; // ring slot of the first part
+uniform int pathSize;
+uniform int ribbonParts; // vertex pairs between the ends, the most any of the instances needs
+
+layout(location=0) in vec2 ribbonDistances; // per instance: start, end
+layout(location=1) in vec4 ribbonProfile; // per instance: offset from the path center, half width, bevel, height
+layout(location=2) in float textureRepeat; // per instance: texture v coordinate per unit of distance, 0 for none
+
+#include "frameuniforms.glsl"
+
+out vec2 vs_texcoord;
+out vec3 vs_position;
+out vec3 vs_normal;
+out float vs_distance;
+
+vec4 pathTexel(int part, int texel)
+{
+    int mask = textureSize(pathParts) / 2 - 1;
+    return texelFetch(pathParts, 2 * ((pathFirst + part) & mask) + texel);
+}
+
+// first part past distance, like std::upper_bound
+int upperBound(float pathDistance)
+{
+    int low = 0;
+    int high = pathSize;
+    while (low < high) {
+        int mid = (low + high) / 2;
+        if (pathDistance < pathTexel(mid, 0).w)
+            high = mid;
+        else
+            low = mid + 1;
+    }
+    return low;
+}
+
+// same as PathTable::stateAt, with the orientation left as a quaternion
+void pathState(float pathDistance, out vec3 center, out vec4 rotation)
+{
+    int part = clamp(upperBound(pathDistance) - 1, 0, pathSize - 2);
+    vec4 from = pathTexel(part, 0);
+    vec4 to = pathTexel(part + 1, 0);
+    float t = (pathDistance - from.w) / (to.w - from.w);
+    center = mix(from.xyz, to.xyz, t);
+    rotation = normalize(mix(pathTexel(part, 1), pathTexel(part + 1, 1), t));
+}
+
+vec3 rotate(vec4 q, vec3 v)
+{
+    return v + 2.0 * cross(q.xyz, cross(q.xyz, v) + q.w * v);
+}
+
+void main(void)
+{
+    float start = ribbonDistances.x;
+    float end = ribbonDistances.y;
+    float offset = ribbonProfile.x;
+    float halfWidth = ribbonProfile.y;
+    float innerHalfWidth = halfWidth - ribbonProfile.z;
+    float height = ribbonProfile.w;
+
+    int pair = gl_VertexID >> 1;
+    float side = float(gl_VertexID & 1);
+
+    float pathDistance;
+    float width;
+    vec3 center;
+    vec4 rotation;
+    if (pair < 4 || pair >= 4 + ribbonParts) {
+        // octagon corners, beveled at both ends of the strip
+        bool atStart = pair < 4;
+        int corner = atStart ? pair : pair - 4 - ribbonParts;
+        float along[4] = float[](-halfWidth, -innerHalfWidth, innerHalfWidth, halfWidth);
+        pathDistance = (atStart ? start : end) + along[corner];
+        width = corner == 0 || corner == 3 ? innerHalfWidth : halfWidth;
+        pathState(pathDistance, center, rotation);
+    } else {
+        // parts strictly between the ends, the pairs this instance doesn't need collapse onto its end
+        width = innerHalfWidth;
+        int part = upperBound(start + halfWidth) + pair - 4;
+        if (part < pathSize && pathTexel(part, 0).w < end - halfWidth) {
+            vec4 centerDistance = pathTexel(part, 0);
+            pathDistance = centerDistance.w;
+            center = centerDistance.xyz;
+            rotation = pathTexel(part, 1);
+        } else {
+            pathDistance = end - halfWidth;
+            pathState(pathDistance, center, rotation);
+        }
+    }
+
+    // path orientation columns are up, side, direction
+    vec3 worldPosition = center + rotate(rotation, vec3(height, offset + (2.0 * side - 1.0) * width, 0.0));
+    vec4 viewPosition = viewMatrix * vec4(worldPosition, 1.0);
+    vs_position = vec3(viewPosition);
+    vs_normal = rotate(rotation, vec3(1.0, 0.0, 0.0));
+    // the texture repeats, keep its coordinates small however far along the path we are
+    vs_texcoord = textureRepeat == 0.0 ? vec2(0.0) : vec2(side, textureRepeat * (pathDistance - start) + fract(textureRepeat * start));
+    vs_distance = distance(worldPosition, eye);
+    gl_Position = projectionMatrix * viewPosition;
+}
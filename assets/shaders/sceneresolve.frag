@@ -0,0 +1,16 @@
+#version 420 core
+
+// averages the samples of the scene drawn by SceneFramebuffer
+layout(binding=0) uniform sampler2DMS sceneTexture;
+uniform int sampleCount;
+
+out vec4 fragColor;
+
+void main(void)
+{
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+    vec4 color = vec4(0.0);
+    for (int i = 0; i < sampleCount; ++i)
+        color += texelFetch(sceneTexture, texel, i);
+    fragColor = color / float(sampleCount);
+}
@@ -0,0 +1,387 @@
+#include "bakedassets.h"
+
+#include "vertexcache.h"
+
+#include <gx/vfs.h>
+
+#include <spdlog/spdlog.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+namespace {
+
+constexpr char Magic[4] = { 'B', 'A', 'K', 'E' };
+constexpr std::uint32_t Version = 3; // bump whenever a layout below changes
+
+enum class AssetType : std::uint32_t {
+    Mesh,
+    Texture,
+    Track,
+};
+
+struct Header {
+    char magic[4];
+    std::uint32_t version;
+    AssetType type;
+    std::uint32_t reserved;
+    std::int64_t sourceTime; // last write time of the source when it was baked, see fileTime
+};
+
+struct MeshHeader {
+    VertexFormat vertexFormat;
+    std::uint32_t vertexCount;
+    std::uint32_t indexCount;
+    glm::vec3 boundsMin;
+    glm::vec3 boundsMax;
+};
+// followed by the vertices, then the indices
+
+struct TextureHeader {
+    std::int32_t width;
+    std::int32_t height;
+    GX::PixelType pixelType;
+};
+// followed by the pixels
+
+struct TrackHeader {
+    std::int32_t beatsPerMinute;
+    std::int32_t eventTracks;
+    std::uint32_t eventCount;
+};
+// followed by audioFile, title and author (each a length and the characters), then the events
+
+struct TrackEvent {
+    std::uint8_t type;
+    std::uint8_t track;
+    std::uint16_t reserved;
+    float start;
+    float duration;
+};
+static_assert(sizeof(TrackEvent) == 12, "unexpected TrackEvent layout");
+
+// a file time as kept in the header; a pack doesn't keep the times of the files in it, and the
+// clock's epoch only has to be the same for the baker and the game
+std::int64_t fileTime(std::filesystem::file_time_type time)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+}
+
+class Writer
+{
+public:
+    Writer(AssetType type, const std::string &sourcePath)
+    {
+        Header header = {};
+        std::memcpy(header.magic, Magic, sizeof(Magic));
+        header.version = Version;
+        header.type = type;
+        std::error_code error;
+        const auto sourceTime = std::filesystem::last_write_time(sourcePath, error);
+        header.sourceTime = error ? std::numeric_limits<std::int64_t>::min() : fileTime(sourceTime);
+        write(header);
+    }
+
+    template<typename T>
+    void write(const T &value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        write(&value, sizeof(value));
+    }
+
+    void write(const void *data, std::size_t size)
+    {
+        const auto *bytes = static_cast<const unsigned char *>(data);
+        m_data.insert(m_data.end(), bytes, bytes + size);
+    }
+
+    void write(const std::string &string)
+    {
+        write(static_cast<std::uint32_t>(string.size()));
+        write(string.data(), string.size());
+    }
+
+    bool save(const std::string &path) const
+    {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char *>(m_data.data()), m_data.size());
+        return file.good();
+    }
+
+private:
+    std::vector<unsigned char> m_data;
+};
+
+class Reader
+{
+public:
+    explicit Reader(const GX::VFS::File &file)
+        : m_pos(file.data())
+        , m_end(file.data() + file.size())
+    {
+    }
+
+    template<typename T>
+    bool read(T &value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        return read(&value, sizeof(value));
+    }
+
+    bool read(void *data, std::size_t size)
+    {
+        if (static_cast<std::size_t>(m_end - m_pos) < size)
+            return false;
+        std::memcpy(data, m_pos, size);
+        m_pos += size;
+        return true;
+    }
+
+    // points data at the next size bytes where they're mapped, instead of copying them
+    bool view(const void *&data, std::size_t size)
+    {
+        if (static_cast<std::size_t>(m_end - m_pos) < size)
+            return false;
+        data = m_pos;
+        m_pos += size;
+        return true;
+    }
+
+    bool read(std::string &string)
+    {
+        std::uint32_t size;
+        if (!read(size))
+            return false;
+        string.resize(size);
+        return read(string.data(), size);
+    }
+
+    template<typename T>
+    bool read(std::vector<T> &values, std::size_t count)
+    {
+        if (static_cast<std::size_t>(m_end - m_pos) / sizeof(T) < count)
+            return false;
+        values.resize(count);
+        return read(values.data(), count * sizeof(T));
+    }
+
+private:
+    const unsigned char *m_pos;
+    const unsigned char *m_end;
+};
+
+bool isKnownType(AssetType type)
+{
+    switch (type) {
+    case AssetType::Mesh:
+    case AssetType::Texture:
+    case AssetType::Track:
+        return true;
+    }
+    return false;
+}
+
+bool hasCurrentFormat(const Header &header)
+{
+    return std::memcmp(header.magic, Magic, sizeof(Magic)) == 0 && header.version == Version;
+}
+
+// a missing source is fine, the baked file might be all that was shipped; otherwise it mustn't have
+// been written since it was baked, whether the baked file is loose or packed
+bool isSourceUnchanged(const Header &header, const std::string &sourcePath)
+{
+    std::error_code error;
+    const auto sourceTime = std::filesystem::last_write_time(sourcePath, error);
+    return error || fileTime(sourceTime) <= header.sourceTime;
+}
+
+// the baked file, if it's current and has the expected header
+GX::VFS::File mapBakedFile(const std::string &sourcePath, AssetType type)
+{
+    const auto path = bakedPath(sourcePath);
+    GX::VFS::File file(path);
+    if (!file)
+        return {};
+    Header header;
+    if (!Reader(file).read(header) || !hasCurrentFormat(header) || header.type != type) {
+        spdlog::info("Ignoring {}, baked by another version", path);
+        return {};
+    }
+    if (!isSourceUnchanged(header, sourcePath)) {
+        spdlog::info("Ignoring {}, {} changed since", path, sourcePath);
+        return {};
+    }
+    return file;
+}
+
+} // namespace
+
+std::string bakedPath(const std::string &sourcePath)
+{
+    return sourcePath + ".baked";
+}
+
+bool isBakedFileCurrent(const std::string &sourcePath, const std::string &path)
+{
+    GX::VFS::File file(path);
+    Header header;
+    return file && Reader(file).read(header) && hasCurrentFormat(header) && isKnownType(header.type) && isSourceUnchanged(header, sourcePath);
+}
+
+bool writeBakedMesh(const std::string &sourcePath, const std::string &path, const ObjModel &model, VertexFormat vertexFormat)
+{
+    BoundingBox box;
+    std::vector<MeshVertex> vertices;
+    vertices.reserve(model.vertices.size());
+    for (const auto &vertex : model.vertices) {
+        box |= vertex.position;
+        vertices.push_back({ vertex.position, vertex.texcoord, vertex.normal });
+    }
+
+    Writer writer(AssetType::Mesh, sourcePath);
+    writer.write(MeshHeader { vertexFormat, static_cast<std::uint32_t>(vertices.size()), static_cast<std::uint32_t>(model.indices.size()), box.min, box.max });
+    switch (vertexFormat) {
+    case VertexFormat::Float:
+        writer.write(vertices.data(), vertices.size() * sizeof(MeshVertex));
+        break;
+    case VertexFormat::Packed:
+        for (const auto &vertex : vertices) {
+            if (!fitsPackedFormat(vertex)) {
+                spdlog::error("{} doesn't fit the packed vertex format", sourcePath);
+                return false;
+            }
+            writer.write(packMeshVertex(vertex));
+        }
+        break;
+    }
+    writer.write(model.indices.data(), model.indices.size() * sizeof(unsigned));
+    return writer.save(path);
+}
+
+bool writeBakedTexture(const std::string &sourcePath, const std::string &path, const GX::Pixmap &pixmap)
+{
+    Writer writer(AssetType::Texture, sourcePath);
+    writer.write(TextureHeader { pixmap.width, pixmap.height, pixmap.pixelType });
+    writer.write(pixmap.pixels.data(), pixmap.pixels.size());
+    return writer.save(path);
+}
+
+bool writeBakedTrack(const std::string &sourcePath, const std::string &path, const Track &track)
+{
+    Writer writer(AssetType::Track, sourcePath);
+    writer.write(TrackHeader { track.beatsPerMinute, track.eventTracks, static_cast<std::uint32_t>(track.events.size()) });
+    writer.write(track.audioFile);
+    writer.write(track.title);
+    writer.write(track.author);
+    for (const auto &event : track.events)
+        writer.write(TrackEvent { static_cast<std::uint8_t>(event.type), static_cast<std::uint8_t>(event.track), 0, event.start, event.duration });
+    return writer.save(path);
+}
+
+std::optional<BakedMesh> readBakedMesh(const std::string &sourcePath)
+{
+    auto file = mapBakedFile(sourcePath, AssetType::Mesh);
+    if (!file)
+        return {};
+    Reader reader(file);
+    Header header;
+    MeshHeader meshHeader;
+    if (!reader.read(header) || !reader.read(meshHeader))
+        return {};
+    std::size_t vertexSize;
+    switch (meshHeader.vertexFormat) {
+    case VertexFormat::Float:
+        vertexSize = sizeof(MeshVertex);
+        break;
+    case VertexFormat::Packed:
+        vertexSize = sizeof(PackedMeshVertex);
+        break;
+    default:
+        spdlog::warn("Ignoring {}, unknown vertex format", bakedPath(sourcePath));
+        return {};
+    }
+    const void *vertices;
+    const void *indices;
+    if (!reader.view(vertices, std::size_t(meshHeader.vertexCount) * vertexSize) || !reader.view(indices, std::size_t(meshHeader.indexCount) * sizeof(unsigned)))
+        return {};
+    BoundingBox boundingBox;
+    boundingBox.min = meshHeader.boundsMin;
+    boundingBox.max = meshHeader.boundsMax;
+    return BakedMesh { std::move(file), meshHeader.vertexFormat, vertices, meshHeader.vertexCount, static_cast<const unsigned *>(indices), meshHeader.indexCount, boundingBox };
+}
+
+GX::Pixmap readBakedTexture(const std::string &sourcePath)
+{
+    const auto file = mapBakedFile(sourcePath, AssetType::Texture);
+    if (!file)
+        return {};
+    Reader reader(file);
+    Header header;
+    TextureHeader textureHeader;
+    if (!reader.read(header) || !reader.read(textureHeader) || textureHeader.width <= 0 || textureHeader.height <= 0)
+        return {};
+    switch (textureHeader.pixelType) {
+    case GX::PixelType::RGBA:
+    case GX::PixelType::Grayscale:
+        break;
+    default:
+        spdlog::warn("Ignoring {}, unknown pixel type", bakedPath(sourcePath));
+        return {};
+    }
+    const void *pixels;
+    if (!reader.view(pixels, std::size_t(textureHeader.width) * textureHeader.height * GX::pixelSizeInBytes(textureHeader.pixelType)))
+        return {};
+    GX::Pixmap pixmap(textureHeader.width, textureHeader.height, textureHeader.pixelType);
+    std::memcpy(pixmap.pixels.data(), pixels, pixmap.pixels.size());
+    return pixmap;
+}
+
+std::optional<ObjModel> loadObjModel(const std::string &sourcePath)
+{
+    const GX::VFS::File source(sourcePath);
+    if (!source) {
+        spdlog::warn("Failed to open {}", sourcePath);
+        return {};
+    }
+
+    auto model = parseObj(source.text());
+    if (!model) {
+        spdlog::warn("Failed to parse {}", sourcePath);
+        return {};
+    }
+
+    // the exporter's triangle order is rarely any good for the vertex cache
+    const auto acmr = averageCacheMissRatio(model->indices, model->vertices.size());
+    optimizeVertexCache(model->indices, model->vertices.size());
+    optimizeVertexFetch(model->vertices, model->indices);
+    spdlog::info("{}: vertices={} triangles={} ACMR={:.3f} (was {:.3f})", sourcePath, model->vertices.size(), model->indices.size() / 3,
+                 averageCacheMissRatio(model->indices, model->vertices.size()), acmr);
+    return model;
+}
+
+std::unique_ptr<Track> readBakedTrack(const std::string &sourcePath)
+{
+    const auto file = mapBakedFile(sourcePath, AssetType::Track);
+    if (!file)
+        return {};
+    Reader reader(file);
+    Header header;
+    TrackHeader trackHeader;
+    auto track = std::make_unique<Track>();
+    std::vector<TrackEvent> events;
+    if (!reader.read(header) || !reader.read(trackHeader) || !reader.read(track->audioFile) || !reader.read(track->title)
+        || !reader.read(track->author) || !reader.read(events, trackHeader.eventCount))
+        return {};
+    track->beatsPerMinute = trackHeader.beatsPerMinute;
+    track->eventTracks = trackHeader.eventTracks;
+    track->events.reserve(events.size());
+    for (const auto &event : events)
+        track->events.push_back({ static_cast<Track::Event::Type>(event.type), event.track, event.start, event.duration });
+    return track;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "geometryutils.h"
+#include "meshvertex.h"
+#include "objparser.h"
+#include "track.h"
+
+#include <gx/pixmap.h>
+#include <gx/vfs.h>
+
+#include <memory>
+#include <optional>
+#include <string>
+
+// Assets converted by tools/baker into binary files the game loads with a single read and no
+// parsing: meshes as indexed, interleaved vertices in a mesh arena's vertex format, already
+// reordered for the vertex cache, textures as the pixels loadPixmap would give, and charts as packed events. The game reads a baked
+// file at its source's path with ".baked" appended, loose or from the mounted pack; it's only used
+// if it was made by the current format version and the source, when there is one, hasn't been
+// written since it was baked, the readers return nothing otherwise and the caller falls back to the
+// source. The data is in native byte order.
+
+std::string bakedPath(const std::string &sourcePath);
+
+// whether the baked file at path would be used for the source at sourcePath
+bool isBakedFileCurrent(const std::string &sourcePath, const std::string &path);
+
+// the writers bake the source at sourcePath into path, which the baker keeps out of the source tree
+bool writeBakedMesh(const std::string &sourcePath, const std::string &path, const ObjModel &model, VertexFormat vertexFormat);
+bool writeBakedTexture(const std::string &sourcePath, const std::string &path, const GX::Pixmap &pixmap);
+bool writeBakedTrack(const std::string &sourcePath, const std::string &path, const Track &track);
+
+// a baked mesh where it's mapped, ready for Mesh::setVertexData and setIndexData
+struct BakedMesh {
+    GX::VFS::File file;
+    VertexFormat vertexFormat;
+    const void *vertices;
+    unsigned vertexCount;
+    const unsigned *indices;
+    unsigned indexCount;
+    BoundingBox boundingBox;
+};
+std::optional<BakedMesh> readBakedMesh(const std::string &sourcePath);
+
+// the model the baker writes for the OBJ file at sourcePath: parsed, then reordered for the vertex
+// cache and vertex fetch; also what meshes are loaded from without a current baked file
+std::optional<ObjModel> loadObjModel(const std::string &sourcePath);
+GX::Pixmap readBakedTexture(const std::string &sourcePath);
+std::unique_ptr<Track> readBakedTrack(const std::string &sourcePath);
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// Beats of one lane, sorted by start time, with a cursor past the ones that are done with. A frame
+// only looks at the beats from the cursor to the end of the hit window, so judging costs the same
+// whatever the length of the chart.
+struct BeatLane {
+    std::vector<unsigned> beats; // sorted by start time
+    std::size_t head = 0; // first beat that may still be judged
+
+    // Moves the cursor past the finished beats at its front and returns the end of the ones starting
+    // before until, to be judged from head.
+    template<typename IsFinished, typename StartTime>
+    std::size_t advance(IsFinished isFinished, StartTime startTime, float until)
+    {
+        while (head < beats.size() && isFinished(beats[head]))
+            ++head;
+        auto end = head;
+        while (end < beats.size() && startTime(beats[end]) < until)
+            ++end;
+        return end;
+    }
+};
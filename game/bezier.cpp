@@ -0,0 +1,61 @@
+#include "bezier.h"
+
+#include <algorithm>
+#include <cassert>
+
+float Bezier::length(float t0, float t1) const
+{
+    // |direction| is smooth, 5 point Gauss-Legendre quadrature is exact to float precision over short spans
+    static constexpr float Nodes[] = { 0.0f, -0.5384693101f, 0.5384693101f, -0.9061798459f, 0.9061798459f };
+    static constexpr float Weights[] = { 0.5688888889f, 0.4786286705f, 0.4786286705f, 0.2369268851f, 0.2369268851f };
+
+    const auto halfSpan = 0.5f * (t1 - t0);
+    const auto mid = 0.5f * (t0 + t1);
+    float sum = 0.0f;
+    for (int i = 0; i < 5; ++i)
+        sum += Weights[i] * glm::length(direction(mid + halfSpan * Nodes[i]));
+    return halfSpan * sum;
+}
+
+BezierArcLength::BezierArcLength(const Bezier &curve, int intervals)
+    : m_curve(curve)
+{
+    assert(intervals > 0);
+    m_lengths.reserve(intervals + 1);
+    m_lengths.push_back(0.0f);
+    for (int i = 0; i < intervals; ++i) {
+        const auto t0 = static_cast<float>(i) / intervals;
+        const auto t1 = static_cast<float>(i + 1) / intervals;
+        m_lengths.push_back(m_lengths.back() + curve.length(t0, t1));
+    }
+}
+
+float BezierArcLength::distance(float t) const
+{
+    const auto intervals = m_lengths.size() - 1;
+    const auto i = std::min(static_cast<std::size_t>(glm::clamp(t, 0.0f, 1.0f) * intervals), intervals - 1);
+    const auto t0 = static_cast<float>(i) / intervals;
+    return m_lengths[i] + m_curve.length(t0, t);
+}
+
+float BezierArcLength::parameter(float distance) const
+{
+    if (distance <= 0.0f)
+        return 0.0f;
+    if (distance >= length())
+        return 1.0f;
+
+    const auto intervals = m_lengths.size() - 1;
+    const auto it = std::upper_bound(m_lengths.begin(), m_lengths.end(), distance);
+    const auto i = static_cast<std::size_t>(std::distance(m_lengths.begin(), it)) - 1;
+    const auto t0 = static_cast<float>(i) / intervals;
+    const auto t1 = static_cast<float>(i + 1) / intervals;
+
+    // linear guess within the interval, then one Newton step on distance(t) - distance
+    const auto fraction = (distance - m_lengths[i]) / (m_lengths[i + 1] - m_lengths[i]);
+    auto t = glm::mix(t0, t1, fraction);
+    const auto speed = glm::length(m_curve.direction(t));
+    if (speed > 0.0f)
+        t -= (m_lengths[i] + m_curve.length(t0, t) - distance) / speed;
+    return glm::clamp(t, t0, t1);
+}
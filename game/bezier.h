@@ -2,6 +2,8 @@
 
 #include <glm/glm.hpp>
 
+#include <vector>
+
 struct Bezier {
     glm::vec3 p0, p1, p2;
 
@@ -14,4 +16,22 @@ struct Bezier {
     {
         return 2.0f * (1.0f - t) * (p1 - p0) + 2.0f * t * (p2 - p1);
     }
+
+    float length(float t0, float t1) const; // arc length between two parameter values
+};
+
+// Arc length of a curve tabulated at evenly spaced parameter values, to go from distance along the
+// curve to parameter value with a binary search and a Newton step.
+class BezierArcLength
+{
+public:
+    explicit BezierArcLength(const Bezier &curve, int intervals = 16);
+
+    float length() const { return m_lengths.back(); }
+    float distance(float t) const;
+    float parameter(float distance) const;
+
+private:
+    Bezier m_curve;
+    std::vector<float> m_lengths; // m_lengths[i] = distance at t = i / intervals
 };
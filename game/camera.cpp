@@ -77,36 +77,5 @@ void Camera::updateViewMatrix()
 
 void Camera::updateFrustum()
 {
-    const auto tang = glm::tan(0.5f * m_fov);
-
-    const auto nearHeight = m_zNear * tang;
-    const auto nearWidth = nearHeight * m_aspectRatio;
-
-    const auto farHeight = m_zFar * tang;
-    const auto farWidth = farHeight * m_aspectRatio;
-
-    // TODO could get these from m_viewMatrix
-    const auto viewZ = glm::normalize(m_eye - m_center);
-    const auto viewX = glm::normalize(glm::cross(m_up, viewZ));
-    const auto viewY = glm::cross(viewZ, viewX);
-
-    const auto nearCenter = m_eye - viewZ * m_zNear;
-    const auto farCenter = m_eye - viewZ * m_zFar;
-
-    const auto ntl = nearCenter + viewY * nearHeight - viewX * nearWidth;
-    const auto ntr = nearCenter + viewY * nearHeight + viewX * nearWidth;
-    const auto nbl = nearCenter - viewY * nearHeight - viewX * nearWidth;
-    const auto nbr = nearCenter - viewY * nearHeight + viewX * nearWidth;
-
-    const auto ftl = farCenter + viewY * farHeight - viewX * farWidth;
-    const auto ftr = farCenter + viewY * farHeight + viewX * farWidth;
-    const auto fbl = farCenter - viewY * farHeight - viewX * farWidth;
-    const auto fbr = farCenter - viewY * farHeight + viewX * farWidth;
-
-    m_frustum.planes[0] = Plane(ntr, ntl, ftl);
-    m_frustum.planes[1] = Plane(nbl, nbr, fbr);
-    m_frustum.planes[2] = Plane(ntl, nbl, fbl);
-    m_frustum.planes[3] = Plane(nbr, ntr, fbr);
-    m_frustum.planes[4] = Plane(ntl, ntr, nbr);
-    m_frustum.planes[5] = Plane(ftr, ftl, fbl);
+    m_frustum = Frustum::fromViewProjection(m_projectionMatrix * m_viewMatrix);
 }
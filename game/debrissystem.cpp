@@ -0,0 +1,149 @@
+#include "debrissystem.h"
+
+#include "frustum.h"
+#include "material.h"
+#include "shadermanager.h"
+#include "transparencypass.h"
+
+#include <gx/texture.h>
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/random.hpp>
+
+using namespace std::string_literals;
+
+namespace {
+
+const GX::GL::Texture *debrisTexture(int index)
+{
+    static const std::array<const GX::GL::Texture *, 4> textures = {
+        cachedTexture("debris0.png"s),
+        cachedTexture("debris1.png"s),
+        cachedTexture("debris2.png"s),
+        cachedTexture("debris3.png"s),
+    };
+    assert(index >= 0 && index < textures.size());
+    return textures[index];
+}
+
+} // namespace
+
+DebrisSystem::DebrisSystem(ShaderManager *shaderManager, TransparencyPass *transparencyPass, const Mesh *mesh)
+    : m_shaderManager(shaderManager)
+    , m_transparencyPass(transparencyPass)
+    , m_mesh(mesh)
+{
+    for (auto &debris : m_debris)
+        debris.reserve(MaxDebrisPerTrack);
+    m_instances.reserve(MaxTracks * MaxDebrisPerTrack);
+    m_boundsCenters.reserve(MaxTracks * MaxDebrisPerTrack);
+    m_boundsRadii.reserve(MaxTracks * MaxDebrisPerTrack);
+    m_visible.reserve(MaxTracks * MaxDebrisPerTrack);
+
+    glGenBuffers(1, &m_instanceBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+    glBufferData(GL_ARRAY_BUFFER, m_instances.capacity() * sizeof(MeshInstance), nullptr, GL_STREAM_DRAW);
+}
+
+DebrisSystem::~DebrisSystem()
+{
+    glDeleteBuffers(1, &m_instanceBuffer);
+}
+
+void DebrisSystem::update(float elapsed, const Frustum &frustum)
+{
+    const auto &box = m_mesh->boundingBox();
+    const auto meshRadius = glm::length(glm::max(glm::abs(box.min), glm::abs(box.max)));
+
+    m_boundsCenters.clear();
+    m_boundsRadii.clear();
+
+    for (auto &debris : m_debris) {
+        std::size_t i = 0;
+        while (i < debris.size()) {
+            auto &fragment = debris[i];
+            fragment.time += elapsed;
+            if (fragment.time >= fragment.life) {
+                // order doesn't matter, swap with the last one
+                fragment = debris.back();
+                debris.pop_back();
+            } else {
+                fragment.position += elapsed * fragment.velocity;
+                const auto rotation = glm::rotate(glm::mat4(1), elapsed * fragment.angularSpeed, fragment.rotationAxis);
+                fragment.orientation *= glm::mat3(rotation);
+                m_boundsCenters.push_back(fragment.position);
+                m_boundsRadii.push_back(fragment.scale * meshRadius);
+                ++i;
+            }
+        }
+    }
+
+    m_visible.resize(m_boundsCenters.size());
+    frustum.testSpheres(m_boundsCenters.data(), m_boundsRadii.data(), m_boundsCenters.size(), m_visible.data());
+
+    m_instances.clear();
+    std::size_t index = 0;
+    for (int track = 0; track < MaxTracks; ++track) {
+        unsigned count = 0;
+        for (const auto &fragment : m_debris[track]) {
+            if (!m_visible[index++])
+                continue;
+            // scale is uniform, so the rotation is good enough as a normal matrix
+            auto modelMatrix = glm::mat4(fragment.scale * fragment.orientation);
+            modelMatrix[3] = glm::vec4(fragment.position, 1);
+            m_instances.push_back({ modelMatrix, fragment.orientation });
+            ++count;
+        }
+        m_instanceCounts[track] = count;
+    }
+    m_culledCount = m_boundsCenters.size() - m_instances.size();
+}
+
+void DebrisSystem::render() const
+{
+    if (m_instances.empty())
+        return;
+
+    glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, m_instances.size() * sizeof(MeshInstance), m_instances.data());
+
+    m_transparencyPass->begin();
+
+    m_shaderManager->useProgram(ShaderManager::LightingTransparent);
+
+    unsigned baseInstance = 0;
+    for (int track = 0; track < MaxTracks; ++track) {
+        const auto count = m_instanceCounts[track];
+        if (count == 0)
+            continue;
+        debrisTexture(track)->bind();
+        m_mesh->renderInstanced(m_instanceBuffer, count, baseInstance);
+        baseInstance += count;
+    }
+
+    m_transparencyPass->end();
+}
+
+void DebrisSystem::spawnDebris(int track, const glm::vec3 &position, const glm::mat3 &orientation, float scale, const glm::vec3 &velocity)
+{
+    assert(track >= 0 && track < MaxTracks);
+    auto &debris = m_debris[track];
+    if (debris.size() >= MaxDebrisPerTrack)
+        return;
+
+    // rotation axis any random vector orthogonal to direction
+    const glm::vec3 u = glm::ballRand(1.0f);
+    const glm::vec3 rotationAxis = glm::cross(u, orientation[0]);
+    const float angularSpeed = glm::linearRand(5.0f, 10.0f);
+
+    debris.push_back({ position, orientation, scale, velocity, rotationAxis, angularSpeed, 0, 3 });
+}
+
+void DebrisSystem::clear()
+{
+    for (auto &debris : m_debris)
+        debris.clear();
+    m_instances.clear();
+    m_instanceCounts.fill(0);
+    m_culledCount = 0;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "meshutils.h"
+
+#include <gx/noncopyable.h>
+
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+class ShaderManager;
+class TransparencyPass;
+struct Frustum;
+
+class DebrisSystem : private GX::NonCopyable
+{
+public:
+    DebrisSystem(ShaderManager *shaderManager, TransparencyPass *transparencyPass, const Mesh *mesh);
+    ~DebrisSystem();
+
+    void update(float elapsed, const Frustum &frustum);
+    void render() const;
+
+    void spawnDebris(int track, const glm::vec3 &position, const glm::mat3 &orientation, float scale, const glm::vec3 &velocity);
+    void clear();
+
+    std::size_t debrisCount() const { return m_boundsCenters.size(); }
+    std::size_t culledCount() const { return m_culledCount; } // by the last update()
+
+private:
+    struct Debris {
+        glm::vec3 position;
+        glm::mat3 orientation;
+        float scale;
+        glm::vec3 velocity;
+        glm::vec3 rotationAxis;
+        float angularSpeed;
+        float time;
+        float life;
+    };
+    static constexpr auto MaxTracks = 4; // one pool (and one draw call) per track material
+    static constexpr auto MaxDebrisPerTrack = 1024;
+
+    ShaderManager *m_shaderManager;
+    TransparencyPass *m_transparencyPass;
+    const Mesh *m_mesh;
+    std::array<std::vector<Debris>, MaxTracks> m_debris;
+    std::vector<MeshInstance> m_instances; // laid out track by track
+    std::array<unsigned, MaxTracks> m_instanceCounts = {};
+    std::vector<glm::vec3> m_boundsCenters;
+    std::vector<float> m_boundsRadii;
+    std::vector<std::uint8_t> m_visible;
+    std::size_t m_culledCount = 0;
+    GLuint m_instanceBuffer = 0; // MeshInstance per debris, see MeshArena::bind
+};
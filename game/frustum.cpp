@@ -1,8 +1,10 @@
 #include "frustum.h"
 
 #include "geometryutils.h"
+#include "simd.h"
 
 #include <algorithm>
+#include <cmath>
 
 Plane::Plane(const glm::vec3 &p0, const glm::vec3 &p1, const glm::vec3 &p2)
 {
@@ -23,21 +25,113 @@ Plane::Plane(const glm::vec3 &n, const glm::vec3 &p)
     d = -glm::dot(n, p);
 }
 
+Plane::Plane(const glm::vec4 &coefficients)
+{
+    const auto v = coefficients / glm::length(glm::vec3(coefficients));
+    a = v.x;
+    b = v.y;
+    c = v.z;
+    d = v.w;
+}
+
+// Gribb/Hartmann: the clip space tests -w <= x, y, z <= w turned into planes in world space
+Frustum Frustum::fromViewProjection(const glm::mat4 &viewProjection)
+{
+    const auto m = glm::transpose(viewProjection); // rows of viewProjection
+    Frustum frustum;
+    frustum.planes[0] = Plane(m[3] - m[1]); // top
+    frustum.planes[1] = Plane(m[3] + m[1]); // bottom
+    frustum.planes[2] = Plane(m[3] + m[0]); // left
+    frustum.planes[3] = Plane(m[3] - m[0]); // right
+    frustum.planes[4] = Plane(m[3] + m[2]); // near
+    frustum.planes[5] = Plane(m[3] - m[2]); // far
+    return frustum;
+}
+
+void transformBoundingBox(const BoundingBox &box, const glm::mat4 &modelMatrix, glm::vec3 &center, glm::vec3 &halfExtent)
+{
+    const auto rotationScale = glm::mat3(modelMatrix);
+    const auto absRotationScale = glm::mat3(glm::abs(rotationScale[0]), glm::abs(rotationScale[1]), glm::abs(rotationScale[2]));
+    center = glm::vec3(modelMatrix * glm::vec4(box.center(), 1));
+    halfExtent = absRotationScale * box.halfExtent();
+}
+
 bool Frustum::contains(const BoundingBox &box, const glm::mat4 &modelMatrix) const
 {
-    std::array<glm::vec3, 8> verts;
-    for (int i = 0; i < 8; ++i) {
-        const auto x = (i & 1) ? box.min.x : box.max.x;
-        const auto y = (i & 2) ? box.min.y : box.max.y;
-        const auto z = (i & 4) ? box.min.z : box.max.z;
-        verts[i] = glm::vec3(modelMatrix * glm::vec4(x, y, z, 1));
+    glm::vec3 center, halfExtent;
+    transformBoundingBox(box, modelMatrix, center, halfExtent);
+    std::uint8_t visible;
+    testBoxes(&center, &halfExtent, 1, &visible);
+    return visible;
+}
+
+void Frustum::testBoxes(const glm::vec3 *centers, const glm::vec3 *halfExtents, std::size_t count, std::uint8_t *visible) const
+{
+    std::size_t i = 0;
+#ifdef HAVE_SSE
+    const auto zero = _mm_setzero_ps();
+    for (; i + 4 <= count; i += 4) {
+        const auto *c = centers + i;
+        const auto *e = halfExtents + i;
+        const auto cx = _mm_setr_ps(c[0].x, c[1].x, c[2].x, c[3].x);
+        const auto cy = _mm_setr_ps(c[0].y, c[1].y, c[2].y, c[3].y);
+        const auto cz = _mm_setr_ps(c[0].z, c[1].z, c[2].z, c[3].z);
+        const auto ex = _mm_setr_ps(e[0].x, e[1].x, e[2].x, e[3].x);
+        const auto ey = _mm_setr_ps(e[0].y, e[1].y, e[2].y, e[3].y);
+        const auto ez = _mm_setr_ps(e[0].z, e[1].z, e[2].z, e[3].z);
+
+        auto outside = zero;
+        for (const auto &plane : planes) {
+            // box is outside if its center is further than its projected radius behind the plane
+            const auto distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.a), cx), _mm_mul_ps(_mm_set1_ps(plane.b), cy)),
+                                             _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.c), cz), _mm_set1_ps(plane.d)));
+            const auto radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(std::abs(plane.a)), ex), _mm_mul_ps(_mm_set1_ps(std::abs(plane.b)), ey)),
+                                           _mm_mul_ps(_mm_set1_ps(std::abs(plane.c)), ez));
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, radius), zero));
+        }
+        const auto mask = _mm_movemask_ps(outside);
+        for (int j = 0; j < 4; ++j)
+            visible[i + j] = (mask & (1 << j)) == 0;
+    }
+#endif
+    for (; i < count; ++i) {
+        const auto &center = centers[i];
+        const auto &halfExtent = halfExtents[i];
+        visible[i] = std::none_of(planes.begin(), planes.end(), [&center, &halfExtent](const Plane &plane) {
+            const auto radius = std::abs(plane.a) * halfExtent.x + std::abs(plane.b) * halfExtent.y + std::abs(plane.c) * halfExtent.z;
+            return plane.distance(center) + radius < 0.0f;
+        });
+    }
+}
+
+void Frustum::testSpheres(const glm::vec3 *centers, const float *radii, std::size_t count, std::uint8_t *visible) const
+{
+    std::size_t i = 0;
+#ifdef HAVE_SSE
+    const auto zero = _mm_setzero_ps();
+    for (; i + 4 <= count; i += 4) {
+        const auto *c = centers + i;
+        const auto cx = _mm_setr_ps(c[0].x, c[1].x, c[2].x, c[3].x);
+        const auto cy = _mm_setr_ps(c[0].y, c[1].y, c[2].y, c[3].y);
+        const auto cz = _mm_setr_ps(c[0].z, c[1].z, c[2].z, c[3].z);
+        const auto radius = _mm_loadu_ps(radii + i);
+
+        auto outside = zero;
+        for (const auto &plane : planes) {
+            const auto distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.a), cx), _mm_mul_ps(_mm_set1_ps(plane.b), cy)),
+                                             _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.c), cz), _mm_set1_ps(plane.d)));
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, radius), zero));
+        }
+        const auto mask = _mm_movemask_ps(outside);
+        for (int j = 0; j < 4; ++j)
+            visible[i + j] = (mask & (1 << j)) == 0;
     }
-    for (const auto &plane : planes) {
-        const auto outside = std::all_of(verts.begin(), verts.end(), [&plane](const auto &v) {
-            return plane.distance(v) < 0.0f;
+#endif
+    for (; i < count; ++i) {
+        const auto &center = centers[i];
+        const auto radius = radii[i];
+        visible[i] = std::none_of(planes.begin(), planes.end(), [&center, radius](const Plane &plane) {
+            return plane.distance(center) + radius < 0.0f;
         });
-        if (outside)
-            return false;
     }
-    return true;
 }
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <array>
+#include <cstddef>
+#include <cstdint>
 #include <glm/glm.hpp>
 
 struct BoundingBox;
@@ -9,6 +11,7 @@ struct Plane {
     Plane() = default;
     Plane(const glm::vec3 &p0, const glm::vec3 &p1, const glm::vec3 &p2);
     Plane(const glm::vec3 &n, const glm::vec3 &p);
+    explicit Plane(const glm::vec4 &coefficients); // normalized
 
     float distance(const glm::vec3 &p) const
     {
@@ -19,6 +22,17 @@ struct Plane {
 };
 
 struct Frustum {
+    static Frustum fromViewProjection(const glm::mat4 &viewProjection);
+
     bool contains(const BoundingBox &box, const glm::mat4 &modelMatrix) const;
+
+    // Batch tests, four at a time with SSE: visible[i] is set to 1 if world space box (or sphere) i
+    // is at least partly inside the frustum, 0 otherwise.
+    void testBoxes(const glm::vec3 *centers, const glm::vec3 *halfExtents, std::size_t count, std::uint8_t *visible) const;
+    void testSpheres(const glm::vec3 *centers, const float *radii, std::size_t count, std::uint8_t *visible) const;
+
     std::array<Plane, 6> planes;
 };
+
+// world space bounds of a local box moved by modelMatrix, as center and half extent
+void transformBoundingBox(const BoundingBox &box, const glm::mat4 &modelMatrix, glm::vec3 &center, glm::vec3 &halfExtent);
@@ -2,6 +2,7 @@
 
 #include <glm/glm.hpp>
 
+#include <limits>
 #include <optional>
 
 struct Triangle;
@@ -29,7 +30,10 @@ struct Ray {
 
 struct BoundingBox {
     glm::vec3 min = glm::vec3(std::numeric_limits<float>::max());
-    glm::vec3 max = glm::vec3(std::numeric_limits<float>::min());
+    glm::vec3 max = glm::vec3(std::numeric_limits<float>::lowest());
+
+    glm::vec3 center() const { return 0.5f * (min + max); }
+    glm::vec3 halfExtent() const { return 0.5f * (max - min); }
 
     bool contains(const glm::vec3 &p) const;
     BoundingBox operator|(const glm::vec3 &p) const;
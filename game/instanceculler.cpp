@@ -0,0 +1,169 @@
+#include "instanceculler.h"
+
+#include "mesh.h"
+#include "meshutils.h"
+#include "shadermanager.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+
+namespace {
+
+// shader storage bindings, see cullinstances.comp
+constexpr GLuint InstancesBinding = 0;
+constexpr GLuint GroupsBinding = 1;
+constexpr GLuint CommandsBinding = 2;
+constexpr GLuint CulledInstancesBinding = 3;
+
+constexpr auto WorkGroupSize = 64;
+
+static_assert(sizeof(MeshInstance) == 25 * sizeof(float), "culled instances are written as floats");
+
+} // namespace
+
+InstanceCuller::InstanceCuller(ShaderManager *shaderManager, const Mesh *mesh)
+    : m_shaderManager(shaderManager)
+    , m_mesh(mesh)
+{
+    static_assert(sizeof(Instance) == 80, "unexpected std430 layout of Instance");
+
+    glGenBuffers(1, &m_instanceBuffer);
+    glGenBuffers(1, &m_groupBuffer);
+    glGenBuffers(1, &m_commandBuffer);
+    glGenBuffers(1, &m_culledBuffer);
+}
+
+InstanceCuller::~InstanceCuller()
+{
+    glDeleteBuffers(1, &m_culledBuffer);
+    glDeleteBuffers(1, &m_commandBuffer);
+    glDeleteBuffers(1, &m_groupBuffer);
+    glDeleteBuffers(1, &m_instanceBuffer);
+}
+
+void InstanceCuller::setGroups(const std::vector<const Material *> &materials, const std::vector<unsigned> &instanceGroups)
+{
+    m_materials = materials;
+    m_instances.clear();
+    for (const auto group : instanceGroups) {
+        assert(group < materials.size());
+        m_instances.push_back({ glm::mat4(1), group, 0, {} });
+    }
+    m_dirtyInstances.clear();
+    m_activeFirst = m_activeEnd = 0;
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_instanceBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, m_instances.size() * sizeof(Instance), m_instances.data(), GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_groupBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, m_materials.size() * sizeof(GLuint), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_commandBuffer);
+    glBufferData(GL_DRAW_INDIRECT_BUFFER, m_materials.size() * sizeof(Mesh::DrawCommand), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+void InstanceCuller::setInstance(std::size_t index, const glm::mat4 &modelMatrix)
+{
+    auto &instance = m_instances[index];
+    instance.modelMatrix = modelMatrix;
+    instance.enabled = 1;
+    m_dirtyInstances.push_back(index);
+    m_activeFirst = std::min(m_activeFirst, index);
+    m_activeEnd = std::max(m_activeEnd, index + 1);
+}
+
+void InstanceCuller::setInstanceEnabled(std::size_t index, bool enabled)
+{
+    auto &instance = m_instances[index];
+    if (instance.enabled == static_cast<GLuint>(enabled))
+        return;
+    instance.enabled = enabled;
+    m_dirtyInstances.push_back(index);
+    if (enabled) {
+        m_activeFirst = std::min(m_activeFirst, index);
+        m_activeEnd = std::max(m_activeEnd, index + 1);
+    }
+}
+
+// one glBufferSubData per run of consecutive changed instances
+void InstanceCuller::uploadInstances()
+{
+    if (m_dirtyInstances.empty())
+        return;
+    std::sort(m_dirtyInstances.begin(), m_dirtyInstances.end());
+    m_dirtyInstances.erase(std::unique(m_dirtyInstances.begin(), m_dirtyInstances.end()), m_dirtyInstances.end());
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_instanceBuffer);
+    auto it = m_dirtyInstances.begin();
+    while (it != m_dirtyInstances.end()) {
+        auto runEnd = std::next(it);
+        while (runEnd != m_dirtyInstances.end() && *runEnd == *std::prev(runEnd) + 1)
+            ++runEnd;
+        const auto first = *it;
+        const auto count = std::distance(it, runEnd);
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, first * sizeof(Instance), count * sizeof(Instance), &m_instances[first]);
+        it = runEnd;
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    m_dirtyInstances.clear();
+}
+
+// Each group gets room in m_culledBuffer for its instances in the active range, starting at
+// m_groupFirst, and a command that starts out with none of them; the shader counts them up.
+void InstanceCuller::layOutGroups()
+{
+    m_groupFirst.assign(m_materials.size(), 0);
+    for (auto i = m_activeFirst; i < m_activeEnd; ++i)
+        ++m_groupFirst[m_instances[i].group];
+    m_commands.clear();
+    GLuint first = 0;
+    for (auto &groupFirst : m_groupFirst) {
+        const auto size = groupFirst;
+        groupFirst = first;
+        m_commands.push_back(m_mesh->drawCommand(0, first));
+        first += size;
+    }
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_groupBuffer);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, m_groupFirst.size() * sizeof(GLuint), m_groupFirst.data());
+    if (first > m_culledCapacity) {
+        m_culledCapacity = std::max<std::size_t>(first, 2 * m_culledCapacity);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_culledBuffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, m_culledCapacity * sizeof(MeshInstance), nullptr, GL_DYNAMIC_COPY);
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_commandBuffer);
+    glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, m_commands.size() * sizeof(Mesh::DrawCommand), m_commands.data());
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+void InstanceCuller::cull()
+{
+    if (m_materials.empty())
+        return;
+
+    uploadInstances();
+    while (m_activeFirst < m_activeEnd && !m_instances[m_activeFirst].enabled)
+        ++m_activeFirst;
+    layOutGroups();
+    if (m_activeFirst == m_activeEnd)
+        return;
+
+    m_shaderManager->useProgram(ShaderManager::CullInstances);
+    const auto &boundingBox = m_mesh->boundingBox();
+    m_shaderManager->setUniform(ShaderManager::BoundsCenter, boundingBox.center());
+    m_shaderManager->setUniform(ShaderManager::BoundsHalfExtent, boundingBox.halfExtent());
+    m_shaderManager->setUniform(ShaderManager::BaseInstance, static_cast<int>(m_activeFirst));
+    m_shaderManager->setUniform(ShaderManager::InstanceEnd, static_cast<int>(m_activeEnd));
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, InstancesBinding, m_instanceBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, GroupsBinding, m_groupBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, CommandsBinding, m_commandBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, CulledInstancesBinding, m_culledBuffer);
+    glDispatchCompute((m_activeEnd - m_activeFirst + WorkGroupSize - 1) / WorkGroupSize, 1, 1);
+
+    // the commands and instances are read by the draws, and rewritten before the next cull
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "mesh.h"
+
+#include <gx/noncopyable.h>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <vector>
+
+class ShaderManager;
+struct Material;
+
+// Instances of one mesh that are culled on the GPU: a compute shader tests each of them against the
+// view frustum and fog distance, appends the visible ones to instanceBuffer() and counts them in the
+// group's command in commandBuffer(), which Renderer draws from directly. Only instances that
+// changed since the last cull() are uploaded, and only the ones from the first enabled instance to
+// the last one set are tested: enabling and disabling instances roughly in index order keeps the
+// cost of a cull to the instances in play, however many there are.
+class InstanceCuller : private GX::NonCopyable
+{
+public:
+    InstanceCuller(ShaderManager *shaderManager, const Mesh *mesh);
+    ~InstanceCuller();
+
+    // one indirect draw command per material; instances are drawn with the material of their group
+    // and start disabled
+    void setGroups(const std::vector<const Material *> &materials, const std::vector<unsigned> &instanceGroups);
+
+    void setInstance(std::size_t index, const glm::mat4 &modelMatrix); // enables it too
+    void setInstanceEnabled(std::size_t index, bool enabled);
+
+    // needs the FrameUniforms for this frame, see ShaderManager::setFrameUniforms
+    void cull();
+
+    const Mesh *mesh() const { return m_mesh; }
+    std::size_t groupCount() const { return m_materials.size(); }
+    const Material *groupMaterial(std::size_t group) const { return m_materials[group]; }
+    GLuint instanceBuffer() const { return m_culledBuffer; } // MeshInstance per visible instance
+    GLuint commandBuffer() const { return m_commandBuffer; } // Mesh::DrawCommand per group
+
+private:
+    struct Instance {
+        glm::mat4 modelMatrix;
+        GLuint group;
+        GLuint enabled;
+        GLuint padding[2];
+    };
+    void uploadInstances();
+    void layOutGroups();
+
+    ShaderManager *m_shaderManager;
+    const Mesh *m_mesh;
+    std::vector<const Material *> m_materials;
+    std::vector<Instance> m_instances;
+    std::vector<std::size_t> m_dirtyInstances; // changed since the last upload, may repeat
+    std::size_t m_activeFirst = 0; // the instances before it are disabled
+    std::size_t m_activeEnd = 0; // the instances from it on were never set
+    std::vector<GLuint> m_groupFirst; // see layOutGroups
+    std::vector<Mesh::DrawCommand> m_commands;
+    GLuint m_instanceBuffer = 0; // Instance, laid out like m_instances
+    GLuint m_groupBuffer = 0; // m_groupFirst
+    GLuint m_commandBuffer = 0; // m_commands
+    GLuint m_culledBuffer = 0;
+    std::size_t m_culledCapacity = 0; // in instances
+};
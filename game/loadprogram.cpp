@@ -2,34 +2,84 @@
 
 #include <glm/glm.hpp>
 #include <gx/shaderprogram.h>
+#include <gx/vfs.h>
 #include <spdlog/spdlog.h>
 
+#include <optional>
 #include <vector>
 
 namespace {
 
+constexpr auto MaxIncludeDepth = 8;
+
 std::string shaderPath(std::string_view basename)
 {
     return std::string("assets/shaders/") + std::string(basename);
 }
 
+// Source of a shader with its `#include "name"` lines replaced by the contents of assets/shaders/name,
+// between #line directives so the compiler's line numbers still match the files.
+std::optional<std::string> shaderSource(std::string_view basename, int depth = 0)
+{
+    if (depth > MaxIncludeDepth) {
+        spdlog::warn("Shader includes nested too deep in {}", basename);
+        return {};
+    }
+    const GX::VFS::File file(shaderPath(basename));
+    if (!file) {
+        spdlog::warn("Failed to load shader {}", basename);
+        return {};
+    }
+
+    constexpr std::string_view IncludeDirective = "#include \"";
+    std::string source;
+    auto text = file.text();
+    int lineNumber = 1;
+    while (!text.empty()) {
+        const auto lineEnd = std::min(text.find('\n'), text.size());
+        const auto line = text.substr(0, lineEnd);
+        text.remove_prefix(std::min(lineEnd + 1, text.size()));
+        ++lineNumber;
+
+        const auto nameEnd = line.rfind('"');
+        if (line.substr(0, IncludeDirective.size()) != IncludeDirective || nameEnd < IncludeDirective.size()) {
+            source.append(line);
+            source.push_back('\n');
+            continue;
+        }
+        const auto included = shaderSource(line.substr(IncludeDirective.size(), nameEnd - IncludeDirective.size()), depth + 1);
+        if (!included)
+            return {};
+        source.append("#line 1\n");
+        source.append(*included);
+        source.append("#line " + std::to_string(lineNumber) + '\n');
+    }
+    return source;
+}
+
+bool addShader(GX::GL::ShaderProgram *program, GLenum type, const char *basename)
+{
+    const auto source = shaderSource(basename);
+    return source && program->addShaderSource(type, source->c_str());
+}
+
 } // namespace
 
 std::unique_ptr<GX::GL::ShaderProgram>
 loadProgram(const char *vertexShader, const char *geometryShader, const char *fragmentShader)
 {
     std::unique_ptr<GX::GL::ShaderProgram> program(new GX::GL::ShaderProgram);
-    if (!program->addShader(GL_VERTEX_SHADER, shaderPath(vertexShader))) {
+    if (!addShader(program.get(), GL_VERTEX_SHADER, vertexShader)) {
         spdlog::warn("Failed to add vertex shader for program {}: {}", vertexShader, program->log());
         return {};
     }
     if (geometryShader) {
-        if (!program->addShader(GL_GEOMETRY_SHADER, shaderPath(geometryShader))) {
+        if (!addShader(program.get(), GL_GEOMETRY_SHADER, geometryShader)) {
             spdlog::warn("Failed to add geometry shader for program {}: {}", geometryShader, program->log());
             return {};
         }
     }
-    if (!program->addShader(GL_FRAGMENT_SHADER, shaderPath(fragmentShader))) {
+    if (!addShader(program.get(), GL_FRAGMENT_SHADER, fragmentShader)) {
         spdlog::warn("Failed to add fragment shader for program {}: {}", fragmentShader, program->log());
         return {};
     }
@@ -39,3 +89,18 @@ loadProgram(const char *vertexShader, const char *geometryShader, const char *fr
     }
     return program;
 }
+
+std::unique_ptr<GX::GL::ShaderProgram>
+loadComputeProgram(const char *computeShader)
+{
+    std::unique_ptr<GX::GL::ShaderProgram> program(new GX::GL::ShaderProgram);
+    if (!addShader(program.get(), GL_COMPUTE_SHADER, computeShader)) {
+        spdlog::warn("Failed to add compute shader for program {}: {}", computeShader, program->log());
+        return {};
+    }
+    if (!program->link()) {
+        spdlog::warn("Failed to link program: {}", program->log());
+        return {};
+    }
+    return program;
+}
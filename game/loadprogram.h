@@ -7,3 +7,4 @@ class ShaderProgram;
 }
 
 std::unique_ptr<GX::GL::ShaderProgram> loadProgram(const char *vertexShader, const char *geometryShader, const char *fragmentShader);
+std::unique_ptr<GX::GL::ShaderProgram> loadComputeProgram(const char *computeShader);
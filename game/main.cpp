@@ -5,12 +5,15 @@
 #include "world.h"
 
 #include <gx/glwindow.h>
+#include <gx/vfs.h>
 
 #include <AL/al.h>
 #include <AL/alc.h>
 #include <GLFW/glfw3.h>
 #include <spdlog/spdlog.h>
 
+#include <chrono>
+
 using namespace std::string_literals;
 
 class GameWindow : public GX::GLWindow
@@ -173,6 +176,8 @@ void GameWindow::keyPressEvent(int key)
     }
     if (m_intro && key == GLFW_KEY_SPACE)
         startGame();
+    if (key == GLFW_KEY_B)
+        m_world->toggleParticleBillboardMode();
 }
 
 void GameWindow::keyReleaseEvent(int key)
@@ -195,8 +200,13 @@ void GameWindow::keyReleaseEvent(int key)
 
 int main(int argc, char *argv[])
 {
+    const auto start = std::chrono::steady_clock::now();
+    if (!GX::VFS::mount("assets.pack"s, "assets"s))
+        spdlog::info("No assets.pack, reading loose assets");
     GameWindow w;
     w.initialize(1200, 600, "test");
+    const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    spdlog::info("Startup took {:.0f} ms", elapsed.count());
     w.enableGLDebugging(GL_DEBUG_SEVERITY_LOW);
     w.renderLoop();
 }
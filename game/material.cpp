@@ -1,5 +1,7 @@
 #include "material.h"
 
+#include "bakedassets.h"
+
 #include <gx/pixmap.h>
 #include <gx/texture.h>
 
@@ -14,6 +16,15 @@ std::string texturePath(const std::string &basename)
 
 } // namespace
 
+Material::Material(ShaderManager::Program program, unsigned flags, const GX::GL::Texture *texture)
+    : program(program)
+    , flags(flags)
+    , texture(texture)
+{
+    static unsigned nextId = 0;
+    id = nextId++;
+}
+
 GX::GL::Texture *cachedTexture(const std::string &textureName)
 {
     if (textureName.empty())
@@ -21,7 +32,11 @@ GX::GL::Texture *cachedTexture(const std::string &textureName)
     static std::unordered_map<std::string, std::unique_ptr<GX::GL::Texture>> cache;
     auto it = cache.find(textureName);
     if (it == cache.end()) {
-        auto texture = std::make_unique<GX::GL::Texture>(GX::loadPixmap(texturePath(textureName)));
+        const auto path = texturePath(textureName);
+        auto pixmap = readBakedTexture(path);
+        if (!pixmap)
+            pixmap = GX::loadPixmap(path);
+        auto texture = std::make_unique<GX::GL::Texture>(pixmap);
         it = cache.emplace(textureName, std::move(texture)).first;
     }
     return it->second.get();
@@ -10,14 +10,18 @@ class Texture;
 }
 
 struct Material {
-    ShaderManager::Program program;
     enum Flags {
         None = 0,
-        Transparent = 1,
+        Transparent = 1, // drawn through TransparencyPass, program must be one of the *Transparent ones
         AdditiveBlend = 2,
     };
+
+    Material(ShaderManager::Program program, unsigned flags, const GX::GL::Texture *texture);
+
+    ShaderManager::Program program;
     unsigned flags;
     const GX::GL::Texture *texture;
+    unsigned id; // small sequential id, for sort keys
 };
 
 GX::GL::Texture *cachedTexture(const std::string &textureName);
@@ -1,31 +1,21 @@
 #include "mesh.h"
 
-namespace {
+#include "mesharena.h"
 
-struct VAOBinder : GX::NonCopyable {
-    VAOBinder(GLuint vao)
-    {
-        glBindVertexArray(vao);
-    }
-
-    ~VAOBinder()
-    {
-        glBindVertexArray(0);
-    }
-};
+#include <cassert>
 
-} // namespace
-
-Mesh::Mesh(GLenum primitive)
-    : m_primitive(primitive)
+Mesh::Mesh(MeshArena *arena, GLenum primitive)
+    : m_arena(arena)
+    , m_primitive(primitive)
 {
+    static unsigned nextId = 0;
+    m_id = nextId++;
 }
 
 Mesh::~Mesh()
 {
-    glDeleteBuffers(1, &m_vertexBuffer);
-    glDeleteBuffers(1, &m_indexBuffer);
-    glDeleteVertexArrays(1, &m_vertexArray);
+    m_arena->freeVertices(m_vertices);
+    m_arena->freeIndices(m_indices);
 }
 
 void Mesh::setVertexCount(unsigned count)
@@ -33,70 +23,52 @@ void Mesh::setVertexCount(unsigned count)
     m_vertexCount = count;
 }
 
-void Mesh::setVertexSize(unsigned size)
-{
-    m_vertexSize = size;
-}
-
 void Mesh::setIndexCount(unsigned count)
 {
     m_indexCount = count;
 }
 
-void Mesh::setVertexAttributes(const std::vector<VertexAttribute> &attributes)
-{
-    m_attributes = attributes;
-}
-
 void Mesh::initialize()
 {
     assert(m_vertexCount > 0);
-    assert(m_vertexSize > 0);
-    assert(!m_attributes.empty());
-
-    glGenBuffers(1, &m_vertexBuffer);
-    glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
-    glBufferData(GL_ARRAY_BUFFER, m_vertexSize * m_vertexCount, nullptr, GL_STATIC_DRAW);
+    assert(m_vertices.count == 0 && m_indices.count == 0);
 
-    if (m_indexCount > 0) {
-        glGenBuffers(1, &m_indexBuffer);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBuffer);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(IndexType) * m_indexCount, nullptr, GL_STATIC_DRAW);
-    }
-
-    glGenVertexArrays(1, &m_vertexArray);
-
-    VAOBinder vaoBinder(m_vertexArray);
-    glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBuffer);
-
-    int index = 0;
-    for (const auto &attribute : m_attributes) {
-        glEnableVertexAttribArray(index);
-        glVertexAttribPointer(index, attribute.componentCount, attribute.type, GL_FALSE, m_vertexSize, reinterpret_cast<GLvoid *>(attribute.offset));
-        ++index;
-    }
+    m_vertices = m_arena->allocateVertices(m_vertexCount);
+    m_indices = m_arena->allocateIndices(m_indexCount);
 }
 
 void Mesh::setVertexData(const void *data)
 {
-    assert(m_vertexBuffer != 0);
-    glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
-    glBufferSubData(GL_ARRAY_BUFFER, 0, m_vertexSize * m_vertexCount, data);
+    assert(m_vertices.count != 0);
+    if (m_vertexCount > m_vertices.count) {
+        m_arena->freeVertices(m_vertices);
+        m_vertices = m_arena->allocateVertices(m_vertexCount);
+    }
+    m_arena->setVertexData({ m_vertices.first, m_vertexCount }, data);
 }
 
 void Mesh::setIndexData(const void *data)
 {
-    assert(m_indexBuffer != 0);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBuffer);
-    glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, sizeof(IndexType) * m_indexCount, data);
+    assert(m_indices.count >= m_indexCount);
+    m_arena->setIndexData({ m_indices.first, m_indexCount }, data);
 }
 
-void Mesh::render() const
+Mesh::DrawCommand Mesh::drawCommand(unsigned instanceCount, unsigned baseInstance) const
 {
-    VAOBinder vaoBinder(m_vertexArray);
-    if (m_indexBuffer != 0)
-        glDrawElements(m_primitive, m_indexCount, GL_UNSIGNED_INT, nullptr);
-    else
-        glDrawArrays(m_primitive, 0, m_vertexCount);
+    static_assert(sizeof(DrawCommand) == 5 * sizeof(GLuint), "unexpected indirect command layout");
+    if (isIndexed())
+        return { m_indexCount, instanceCount, m_indices.first, m_vertices.first, baseInstance };
+    return { m_vertexCount, instanceCount, m_vertices.first, baseInstance, 0 };
+}
+
+void Mesh::renderInstanced(GLuint instanceBuffer, unsigned instanceCount, unsigned baseInstance) const
+{
+    m_arena->bind(instanceBuffer);
+    if (isIndexed()) {
+        const auto *indices = reinterpret_cast<const GLvoid *>(sizeof(IndexType) * m_indices.first);
+        glDrawElementsInstancedBaseVertexBaseInstance(m_primitive, m_indexCount, GL_UNSIGNED_INT, indices, instanceCount, m_vertices.first, baseInstance);
+    } else {
+        glDrawArraysInstancedBaseInstance(m_primitive, m_vertices.first, m_vertexCount, instanceCount, baseInstance);
+    }
+    glBindVertexArray(0); // the arena's element array binding is vertex array state, keep it out of reach
 }
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "geometryutils.h"
+
 #include <gx/noncopyable.h>
 
 #include <GL/glew.h>
@@ -8,37 +10,75 @@
 #include <memory>
 #include <vector>
 
+class MeshArena;
+
+// Vertices (and optionally indices) in a MeshArena, which has the buffers and vertex format.
 class Mesh : private GX::NonCopyable
 {
 public:
     using IndexType = unsigned;
 
-    explicit Mesh(GLenum primitive = GL_TRIANGLES);
+    explicit Mesh(MeshArena *arena, GLenum primitive = GL_TRIANGLES);
     ~Mesh();
 
     void setVertexCount(unsigned count);
-    void setVertexSize(unsigned size);
     void setIndexCount(unsigned count);
     struct VertexAttribute {
         unsigned componentCount;
         GLenum type;
         unsigned offset;
+        bool normalized = false; // integer types mapped to [0, 1] (or [-1, 1] if signed)
+        bool integer = false; // read as ints by the shader, not converted to float
     };
-    void setVertexAttributes(const std::vector<VertexAttribute> &attributes);
+
+    // shader location of the first per-instance attribute, after position, texcoord and normal
+    static constexpr unsigned FirstInstanceAttribute = 3;
 
     void initialize();
-    void setVertexData(const void *data); // is this polymorphism?
+    void setVertexData(const void *data); // is this polymorphism? takes a new range if the vertex count grew
     void setIndexData(const void *data);
 
-    void render() const;
+    unsigned id() const { return m_id; } // small sequential id, for sort keys
+
+    void setBoundingBox(const BoundingBox &box) { m_boundingBox = box; }
+    const BoundingBox &boundingBox() const { return m_boundingBox; } // in model space
+
+    MeshArena *arena() const { return m_arena; }
+    GLenum primitive() const { return m_primitive; }
+    bool isIndexed() const { return m_indexCount > 0; }
+    unsigned firstVertex() const { return m_vertices.first; }
+    unsigned vertexCount() const { return m_vertexCount; }
+    unsigned firstIndex() const { return m_indices.first; }
+    unsigned indexCount() const { return m_indexCount; }
+
+    // Indexed meshes use the glMultiDrawElementsIndirect command layout as is. glMultiDrawArraysIndirect
+    // reads count, instanceCount, first and baseInstance, so non-indexed meshes have baseInstance where
+    // baseVertex would go; either way commands for any mesh can share one buffer and stride.
+    struct DrawCommand {
+        GLuint count;
+        GLuint instanceCount;
+        GLuint first; // index, or vertex for non-indexed meshes
+        GLuint baseVertex; // baseInstance for non-indexed meshes
+        GLuint baseInstance;
+    };
+    DrawCommand drawCommand(unsigned instanceCount, unsigned baseInstance) const;
+
+    // instanceBuffer has the per-instance attributes, in the layout the arena was set up with
+    void renderInstanced(GLuint instanceBuffer, unsigned instanceCount, unsigned baseInstance = 0) const;
+
+    // span of vertices or indices in the arena
+    struct Range {
+        unsigned first = 0;
+        unsigned count = 0;
+    };
 
 private:
+    unsigned m_id;
+    MeshArena *m_arena;
     GLenum m_primitive;
     unsigned m_vertexCount = 0;
-    unsigned m_vertexSize = 0;
     unsigned m_indexCount = 0;
-    std::vector<VertexAttribute> m_attributes;
-    GLuint m_vertexBuffer = 0;
-    GLuint m_indexBuffer = 0;
-    GLuint m_vertexArray = 0;
+    Range m_vertices; // allocated in the arena, count is the capacity
+    Range m_indices;
+    BoundingBox m_boundingBox;
 };
@@ -0,0 +1,190 @@
+#include "mesharena.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace {
+
+constexpr unsigned InitialVertexCapacity = 1 << 16;
+constexpr unsigned InitialIndexCapacity = 1 << 16;
+
+// vertex buffer binding points of the vertex array
+constexpr GLuint VertexBinding = 0;
+constexpr GLuint InstanceBinding = 1;
+
+} // namespace
+
+bool MeshArena::Allocator::allocate(unsigned count, Range &range)
+{
+    auto it = std::find_if(m_freeRanges.begin(), m_freeRanges.end(), [count](const Range &free) {
+        return free.count >= count;
+    });
+    if (it == m_freeRanges.end())
+        return false;
+    range = { it->first, count };
+    it->first += count;
+    it->count -= count;
+    if (it->count == 0)
+        m_freeRanges.erase(it);
+    return true;
+}
+
+void MeshArena::Allocator::free(const Range &range)
+{
+    if (range.count == 0)
+        return;
+    auto it = std::lower_bound(m_freeRanges.begin(), m_freeRanges.end(), range.first, [](const Range &free, unsigned first) {
+        return free.first < first;
+    });
+    it = m_freeRanges.insert(it, range);
+    if (auto next = std::next(it); next != m_freeRanges.end() && it->first + it->count == next->first) {
+        it->count += next->count;
+        m_freeRanges.erase(next);
+    }
+    if (it != m_freeRanges.begin()) {
+        if (auto prev = std::prev(it); prev->first + prev->count == it->first) {
+            prev->count += it->count;
+            m_freeRanges.erase(it);
+        }
+    }
+}
+
+void MeshArena::Allocator::grow(unsigned capacity)
+{
+    assert(capacity > m_capacity);
+    free({ m_capacity, capacity - m_capacity });
+    m_capacity = capacity;
+}
+
+unsigned MeshArena::Allocator::allocated() const
+{
+    unsigned freeCount = 0;
+    for (const auto &range : m_freeRanges)
+        freeCount += range.count;
+    return m_capacity - freeCount;
+}
+
+MeshArena::MeshArena(VertexFormat vertexFormat, unsigned vertexSize, const std::vector<Mesh::VertexAttribute> &vertexAttributes,
+                     unsigned instanceSize, const std::vector<Mesh::VertexAttribute> &instanceAttributes)
+    : m_vertexFormat(vertexFormat)
+    , m_vertexSize(vertexSize)
+    , m_instanceSize(instanceSize)
+{
+    assert(vertexAttributes.size() <= Mesh::FirstInstanceAttribute);
+
+    glGenBuffers(1, &m_vertexBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, m_vertexSize * InitialVertexCapacity, nullptr, GL_STATIC_DRAW);
+    m_vertices.grow(InitialVertexCapacity);
+
+    glGenVertexArrays(1, &m_vertexArray);
+    glBindVertexArray(m_vertexArray);
+
+    glGenBuffers(1, &m_indexBuffer);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBuffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(Mesh::IndexType) * InitialIndexCapacity, nullptr, GL_STATIC_DRAW);
+    m_indices.grow(InitialIndexCapacity);
+
+    // attribute formats are fixed, only the buffers bound to them change
+    const auto setAttributeFormat = [](GLuint index, const Mesh::VertexAttribute &attribute, GLuint binding) {
+        glEnableVertexAttribArray(index);
+        if (attribute.integer)
+            glVertexAttribIFormat(index, attribute.componentCount, attribute.type, attribute.offset);
+        else
+            glVertexAttribFormat(index, attribute.componentCount, attribute.type, attribute.normalized, attribute.offset);
+        glVertexAttribBinding(index, binding);
+    };
+    GLuint index = 0;
+    for (const auto &attribute : vertexAttributes)
+        setAttributeFormat(index++, attribute, VertexBinding);
+    glBindVertexBuffer(VertexBinding, m_vertexBuffer, 0, m_vertexSize);
+
+    index = Mesh::FirstInstanceAttribute;
+    for (const auto &attribute : instanceAttributes)
+        setAttributeFormat(index++, attribute, InstanceBinding);
+    glVertexBindingDivisor(InstanceBinding, 1);
+
+    glBindVertexArray(0);
+}
+
+MeshArena::~MeshArena()
+{
+    glDeleteVertexArrays(1, &m_vertexArray);
+    glDeleteBuffers(1, &m_indexBuffer);
+    glDeleteBuffers(1, &m_vertexBuffer);
+}
+
+MeshArena::Range MeshArena::allocateVertices(unsigned count)
+{
+    return allocate(m_vertices, m_vertexBuffer, GL_ARRAY_BUFFER, m_vertexSize, count);
+}
+
+MeshArena::Range MeshArena::allocateIndices(unsigned count)
+{
+    return allocate(m_indices, m_indexBuffer, GL_ELEMENT_ARRAY_BUFFER, sizeof(Mesh::IndexType), count);
+}
+
+void MeshArena::freeVertices(const Range &range)
+{
+    m_vertices.free(range);
+}
+
+void MeshArena::freeIndices(const Range &range)
+{
+    m_indices.free(range);
+}
+
+MeshArena::Range MeshArena::allocate(Allocator &allocator, GLuint &buffer, GLenum target, unsigned elementSize, unsigned count)
+{
+    Range range;
+    if (count == 0 || allocator.allocate(count, range))
+        return range;
+
+    const auto oldCapacity = allocator.capacity();
+    const auto newCapacity = std::max(2 * oldCapacity, oldCapacity + count);
+    growBuffer(buffer, target, elementSize * oldCapacity, elementSize * newCapacity);
+    allocator.grow(newCapacity);
+
+    [[maybe_unused]] const auto allocated = allocator.allocate(count, range);
+    assert(allocated);
+    return range;
+}
+
+// copies the contents over to a bigger buffer, and points the vertex array to it
+void MeshArena::growBuffer(GLuint &buffer, GLenum target, unsigned oldSize, unsigned newSize)
+{
+    GLuint newBuffer;
+    glGenBuffers(1, &newBuffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, newBuffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, newSize, nullptr, GL_STATIC_DRAW);
+    glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, oldSize);
+    glDeleteBuffers(1, &buffer);
+    buffer = newBuffer;
+
+    glBindVertexArray(m_vertexArray);
+    if (target == GL_ELEMENT_ARRAY_BUFFER)
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer);
+    else
+        glBindVertexBuffer(VertexBinding, buffer, 0, m_vertexSize);
+    glBindVertexArray(0);
+}
+
+void MeshArena::setVertexData(const Range &range, const void *data)
+{
+    glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
+    glBufferSubData(GL_ARRAY_BUFFER, m_vertexSize * range.first, m_vertexSize * range.count, data);
+}
+
+void MeshArena::setIndexData(const Range &range, const void *data)
+{
+    // the element array binding is vertex array state, don't touch whatever is bound
+    glBindBuffer(GL_COPY_WRITE_BUFFER, m_indexBuffer);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, sizeof(Mesh::IndexType) * range.first, sizeof(Mesh::IndexType) * range.count, data);
+}
+
+void MeshArena::bind(GLuint instanceBuffer) const
+{
+    glBindVertexArray(m_vertexArray);
+    glBindVertexBuffer(InstanceBinding, instanceBuffer, 0, m_instanceSize);
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "mesh.h"
+#include "meshvertex.h"
+
+#include <gx/noncopyable.h>
+
+#include <GL/glew.h>
+
+#include <vector>
+
+// Vertex and index ranges for many meshes, suballocated from one vertex buffer and one index
+// buffer shared by all of them, with a single vertex array set up for their vertex format and the
+// per-instance attributes. Drawing any number of meshes from an arena takes one vertex array bind,
+// and they can go in the same multi-draw call.
+class MeshArena : private GX::NonCopyable
+{
+public:
+    MeshArena(VertexFormat vertexFormat, unsigned vertexSize, const std::vector<Mesh::VertexAttribute> &vertexAttributes,
+              unsigned instanceSize, const std::vector<Mesh::VertexAttribute> &instanceAttributes);
+    ~MeshArena();
+
+    using Range = Mesh::Range;
+    Range allocateVertices(unsigned count);
+    Range allocateIndices(unsigned count);
+    void freeVertices(const Range &range);
+    void freeIndices(const Range &range);
+
+    void setVertexData(const Range &range, const void *data);
+    void setIndexData(const Range &range, const void *data);
+
+    VertexFormat vertexFormat() const { return m_vertexFormat; }
+    unsigned vertexSize() const { return m_vertexSize; }
+    unsigned allocatedVertices() const { return m_vertices.allocated(); }
+
+    // binds the vertex array, with the per-instance attributes read from instanceBuffer
+    void bind(GLuint instanceBuffer) const;
+
+private:
+    // first fit over the free ranges, sorted and coalesced
+    class Allocator
+    {
+    public:
+        bool allocate(unsigned count, Range &range);
+        void free(const Range &range);
+        void grow(unsigned capacity);
+        unsigned capacity() const { return m_capacity; }
+        unsigned allocated() const;
+
+    private:
+        unsigned m_capacity = 0;
+        std::vector<Range> m_freeRanges;
+    };
+    Range allocate(Allocator &allocator, GLuint &buffer, GLenum target, unsigned elementSize, unsigned count);
+    void growBuffer(GLuint &buffer, GLenum target, unsigned oldSize, unsigned newSize);
+
+    VertexFormat m_vertexFormat;
+    unsigned m_vertexSize;
+    unsigned m_instanceSize;
+    Allocator m_vertices;
+    Allocator m_indices;
+    GLuint m_vertexBuffer = 0;
+    GLuint m_indexBuffer = 0;
+    GLuint m_vertexArray = 0;
+};
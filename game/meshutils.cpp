@@ -1,100 +1,125 @@
 #include "meshutils.h"
 
+#include "bakedassets.h"
 #include "mesh.h"
 
 #include <glm/glm.hpp>
 #include <spdlog/spdlog.h>
 
-#include <boost/algorithm/string.hpp>
-
-#include <fstream>
+#include <algorithm>
+#include <iterator>
 #include <vector>
 
-std::unique_ptr<Mesh> makeMesh(const std::vector<MeshVertex> &vertices, GLenum primitive)
+const std::vector<Mesh::VertexAttribute> &meshVertexAttributes(VertexFormat format)
 {
     static const std::vector<Mesh::VertexAttribute> attributes = {
         { 3, GL_FLOAT, offsetof(MeshVertex, position) },
         { 2, GL_FLOAT, offsetof(MeshVertex, texcoord) },
         { 3, GL_FLOAT, offsetof(MeshVertex, normal) },
     };
+    static const std::vector<Mesh::VertexAttribute> packedAttributes = {
+        { 3, GL_HALF_FLOAT, offsetof(PackedMeshVertex, position) },
+        { 2, GL_UNSIGNED_SHORT, offsetof(PackedMeshVertex, texcoord), true },
+        { 4, GL_INT_2_10_10_10_REV, offsetof(PackedMeshVertex, normal), true }, // the shaders only read xyz
+    };
+    return format == VertexFormat::Packed ? packedAttributes : attributes;
+}
 
-    auto mesh = std::make_unique<Mesh>(primitive);
-    mesh->setVertexCount(vertices.size());
-    mesh->setVertexSize(sizeof(MeshVertex));
-    mesh->setVertexAttributes(attributes);
+std::size_t vertexSize(VertexFormat format)
+{
+    return format == VertexFormat::Packed ? sizeof(PackedMeshVertex) : sizeof(MeshVertex);
+}
 
-    mesh->initialize();
-    mesh->setVertexData(vertices.data());
+const std::vector<Mesh::VertexAttribute> &meshInstanceAttributes()
+{
+    static const std::vector<Mesh::VertexAttribute> attributes = {
+        { 4, GL_FLOAT, offsetof(MeshInstance, modelMatrix) },
+        { 4, GL_FLOAT, offsetof(MeshInstance, modelMatrix) + sizeof(glm::vec4) },
+        { 4, GL_FLOAT, offsetof(MeshInstance, modelMatrix) + 2 * sizeof(glm::vec4) },
+        { 4, GL_FLOAT, offsetof(MeshInstance, modelMatrix) + 3 * sizeof(glm::vec4) },
+        { 3, GL_FLOAT, offsetof(MeshInstance, normalMatrix) },
+        { 3, GL_FLOAT, offsetof(MeshInstance, normalMatrix) + sizeof(glm::vec3) },
+        { 3, GL_FLOAT, offsetof(MeshInstance, normalMatrix) + 2 * sizeof(glm::vec3) },
+    };
+    return attributes;
+}
 
-    return mesh;
+BoundingBox boundingBox(const std::vector<MeshVertex> &vertices)
+{
+    BoundingBox box;
+    for (const auto &vertex : vertices)
+        box |= vertex.position;
+    return box;
 }
 
-std::unique_ptr<Mesh> loadMesh(const std::string &path)
+std::unique_ptr<MeshArena> makeMeshArena(VertexFormat format)
 {
-    std::ifstream ifs(path);
-    if (ifs.fail()) {
-        spdlog::warn("Failed to open {}", path);
-        return {};
-    }
+    return std::make_unique<MeshArena>(format, vertexSize(format), meshVertexAttributes(format), sizeof(MeshInstance), meshInstanceAttributes());
+}
 
-    std::vector<glm::vec3> positions;
-    std::vector<glm::vec2> texcoords;
-    std::vector<glm::vec3> normals;
-    struct Vertex {
-        int positionIndex;
-        int texcoordIndex;
-        int normalIndex;
-    };
-    using Face = std::vector<Vertex>;
-    std::vector<Face> faces;
+std::unique_ptr<Mesh> makeMesh(MeshArena *arena, const std::vector<MeshVertex> &vertices, GLenum primitive)
+{
+    return makeMesh(arena, vertices, {}, primitive);
+}
 
-    std::string line;
-    while (std::getline(ifs, line)) {
-        std::vector<std::string> tokens;
-        boost::split(tokens, line, boost::is_any_of(" \t"), boost::token_compress_on);
-        if (tokens.empty())
-            continue;
-        if (tokens.front() == "v") {
-            assert(tokens.size() == 4);
-            positions.emplace_back(std::stof(tokens[1]), std::stof(tokens[2]), std::stof(tokens[3]));
-        } else if (tokens.front() == "vt") {
-            assert(tokens.size() == 3);
-            texcoords.emplace_back(std::stof(tokens[1]), std::stof(tokens[2]));
-        } else if (tokens.front() == "vn") {
-            assert(tokens.size() == 4);
-            normals.emplace_back(std::stof(tokens[1]), std::stof(tokens[2]), std::stof(tokens[3]));
-        } else if (tokens.front() == "f") {
-            Face f;
-            for (auto it = std::next(tokens.begin()); it != tokens.end(); ++it) {
-                std::vector<std::string> components;
-                boost::split(components, *it, boost::is_any_of("/"), boost::token_compress_off);
-                assert(components.size() == 3);
-                f.push_back({ std::stoi(components[0]) - 1, std::stoi(components[1]) - 1, std::stoi(components[2]) - 1 });
-            }
-            faces.push_back(f);
-        }
-    }
+std::unique_ptr<Mesh> makeMesh(MeshArena *arena, const std::vector<MeshVertex> &vertices, const std::vector<Mesh::IndexType> &indices, GLenum primitive)
+{
+    auto mesh = std::make_unique<Mesh>(arena, primitive);
+    mesh->setVertexCount(vertices.size());
+    mesh->setIndexCount(indices.size());
 
-    spdlog::info("positions={} normals={} faces={}", positions.size(), normals.size(), faces.size());
+    mesh->initialize();
+    if (!indices.empty())
+        mesh->setIndexData(indices.data());
+    assert(arena->vertexSize() == vertexSize(arena->vertexFormat()));
+    switch (arena->vertexFormat()) {
+    case VertexFormat::Float:
+        mesh->setVertexData(vertices.data());
+        break;
+    case VertexFormat::Packed: {
+        const auto outOfRange = std::count_if(vertices.begin(), vertices.end(), [](const MeshVertex &vertex) {
+            return !fitsPackedFormat(vertex);
+        });
+        if (outOfRange != 0)
+            spdlog::warn("{} of {} vertices don't fit the packed vertex format, they were clamped", outOfRange, vertices.size());
+        std::vector<PackedMeshVertex> packedVertices;
+        packedVertices.reserve(vertices.size());
+        std::transform(vertices.begin(), vertices.end(), std::back_inserter(packedVertices), packMeshVertex);
+        mesh->setVertexData(packedVertices.data());
+        break;
+    }
+    }
+    mesh->setBoundingBox(boundingBox(vertices));
 
-    std::vector<MeshVertex> vertices;
+    return mesh;
+}
 
-    for (const auto &face : faces) {
-        for (size_t i = 1; i < face.size() - 1; ++i) {
-            const auto toVertex = [i, &positions, &texcoords, &normals](const auto &vertex) {
-                assert(vertex.positionIndex < positions.size());
-                assert(vertex.texcoordIndex < texcoords.size());
-                assert(vertex.normalIndex < normals.size());
-                return MeshVertex { positions[vertex.positionIndex], texcoords[vertex.texcoordIndex], normals[vertex.normalIndex] };
-            };
-            const auto v0 = toVertex(face[0]);
-            const auto v1 = toVertex(face[i]);
-            const auto v2 = toVertex(face[i + 1]);
-            vertices.push_back(v0);
-            vertices.push_back(v1);
-            vertices.push_back(v2);
+std::unique_ptr<Mesh> loadMesh(MeshArena *arena, const std::string &path)
+{
+    // baked vertices in the arena's format go to it straight from where they're mapped
+    if (const auto baked = readBakedMesh(path)) {
+        if (baked->vertexFormat == arena->vertexFormat()) {
+            auto mesh = std::make_unique<Mesh>(arena);
+            mesh->setVertexCount(baked->vertexCount);
+            mesh->setIndexCount(baked->indexCount);
+            mesh->initialize();
+            if (baked->indexCount != 0)
+                mesh->setIndexData(baked->indices);
+            mesh->setVertexData(baked->vertices);
+            mesh->setBoundingBox(baked->boundingBox);
+            return mesh;
         }
+        spdlog::info("Ignoring {}, baked in another vertex format", bakedPath(path));
     }
 
-    return makeMesh(vertices);
+    const auto model = loadObjModel(path);
+    if (!model)
+        return {};
+
+    std::vector<MeshVertex> vertices;
+    vertices.reserve(model->vertices.size());
+    std::transform(model->vertices.begin(), model->vertices.end(), std::back_inserter(vertices), [](const ObjModel::Vertex &vertex) {
+        return MeshVertex { vertex.position, vertex.texcoord, vertex.normal };
+    });
+    return makeMesh(arena, vertices, model->indices);
 }
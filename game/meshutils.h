@@ -1,16 +1,31 @@
 #pragma once
 
 #include "mesh.h"
+#include "mesharena.h"
+#include "meshvertex.h"
 
 #include <memory>
 #include <string>
 
-struct MeshVertex {
-    glm::vec3 position;
-    glm::vec2 texcoord;
-    glm::vec3 normal;
+const std::vector<Mesh::VertexAttribute> &meshVertexAttributes(VertexFormat format = VertexFormat::Float);
+std::size_t vertexSize(VertexFormat format);
+
+// per-instance data read by the mesh shaders, see MeshArena::bind
+struct MeshInstance {
+    glm::mat4 modelMatrix;
+    glm::mat3 normalMatrix;
 };
 
-std::unique_ptr<Mesh> makeMesh(const std::vector<MeshVertex> &vertices, GLenum primitive = GL_TRIANGLES);
+const std::vector<Mesh::VertexAttribute> &meshInstanceAttributes();
+
+BoundingBox boundingBox(const std::vector<MeshVertex> &vertices);
+
+// arena for meshes drawn with MeshInstance data
+std::unique_ptr<MeshArena> makeMeshArena(VertexFormat format = VertexFormat::Float);
+
+// vertices are converted to the arena's vertex format
+std::unique_ptr<Mesh> makeMesh(MeshArena *arena, const std::vector<MeshVertex> &vertices, GLenum primitive = GL_TRIANGLES);
+std::unique_ptr<Mesh> makeMesh(MeshArena *arena, const std::vector<MeshVertex> &vertices, const std::vector<Mesh::IndexType> &indices, GLenum primitive = GL_TRIANGLES);
 
-std::unique_ptr<Mesh> loadMesh(const std::string &path);
+// indexed, see parseObj, and reordered for the vertex cache; from the baked mesh if it's current
+std::unique_ptr<Mesh> loadMesh(MeshArena *arena, const std::string &path);
@@ -0,0 +1,36 @@
+#include "meshvertex.h"
+
+#include <glm/gtc/packing.hpp>
+
+#include <cmath>
+
+namespace {
+
+constexpr auto MaxHalfFloat = 65504.0f;
+
+} // namespace
+
+PackedMeshVertex packMeshVertex(const MeshVertex &vertex)
+{
+    PackedMeshVertex packed;
+    for (int i = 0; i < 3; ++i)
+        packed.position[i] = glm::packHalf1x16(vertex.position[i]);
+    packed.position[3] = 0;
+    for (int i = 0; i < 2; ++i)
+        packed.texcoord[i] = glm::packUnorm1x16(vertex.texcoord[i]); // clamps to [0, 1]
+    packed.normal = glm::packSnorm3x10_1x2(glm::vec4(vertex.normal, 0));
+    return packed;
+}
+
+bool fitsPackedFormat(const MeshVertex &vertex)
+{
+    for (int i = 0; i < 3; ++i) {
+        if (!(std::abs(vertex.position[i]) <= MaxHalfFloat))
+            return false;
+    }
+    for (int i = 0; i < 2; ++i) {
+        if (!(vertex.texcoord[i] >= 0.0f && vertex.texcoord[i] <= 1.0f))
+            return false;
+    }
+    return true;
+}
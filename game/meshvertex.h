@@ -0,0 +1,35 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+
+// layout of the vertices in a mesh arena, see MeshArena
+enum class VertexFormat {
+    Float, // MeshVertex
+    Packed, // PackedMeshVertex
+};
+
+// what the game's mesh arena holds, and so what meshes are baked in
+constexpr auto GameVertexFormat = VertexFormat::Packed;
+
+struct MeshVertex {
+    glm::vec3 position;
+    glm::vec2 texcoord;
+    glm::vec3 normal;
+};
+
+// MeshVertex in half the size, read by the same shaders: the attributes are converted to floats
+// when they're fetched
+struct PackedMeshVertex {
+    std::uint16_t position[4]; // half floats, the last one is padding
+    std::uint16_t texcoord[2]; // 16 bit unorm, so in [0, 1]
+    std::uint32_t normal; // 10 bit snorm x, y, z (GL_INT_2_10_10_10_REV)
+};
+static_assert(sizeof(PackedMeshVertex) == sizeof(MeshVertex) / 2, "unexpected PackedMeshVertex size");
+
+// clamps what doesn't fit, see fitsPackedFormat
+PackedMeshVertex packMeshVertex(const MeshVertex &vertex);
+// whether the vertex survives packing: positions within the half float range, texcoords in [0, 1]
+// (so no tiling)
+bool fitsPackedFormat(const MeshVertex &vertex);
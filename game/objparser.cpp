@@ -0,0 +1,254 @@
+#include "objparser.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <utility>
+
+namespace {
+
+// indices into the position, texcoord and normal lists, -1 if the face didn't give one
+struct VertexKey {
+    int position;
+    int texcoord;
+    int normal;
+
+    bool operator==(const VertexKey &other) const
+    {
+        return position == other.position && texcoord == other.texcoord && normal == other.normal;
+    }
+};
+
+// open addressing with linear probing, keys are never removed
+class VertexIndexTable
+{
+public:
+    VertexIndexTable()
+        : m_slots(1024)
+    {
+    }
+
+    // index of the vertex for key, or newIndex (which is then added) if there's none yet
+    std::pair<unsigned, bool> insert(const VertexKey &key, unsigned newIndex)
+    {
+        if (2 * (m_size + 1) > m_slots.size())
+            grow();
+        auto &slot = find(key);
+        if (slot.index != Empty)
+            return { slot.index, false };
+        slot = { key, newIndex };
+        ++m_size;
+        return { newIndex, true };
+    }
+
+private:
+    static constexpr auto Empty = ~0u;
+    struct Slot {
+        VertexKey key;
+        unsigned index = Empty;
+    };
+
+    Slot &find(const VertexKey &key)
+    {
+        const auto mask = m_slots.size() - 1;
+        for (auto i = hash(key) & mask;; i = (i + 1) & mask) {
+            auto &slot = m_slots[i];
+            if (slot.index == Empty || slot.key == key)
+                return slot;
+        }
+    }
+
+    void grow()
+    {
+        std::vector<Slot> slots(2 * m_slots.size());
+        slots.swap(m_slots);
+        for (const auto &slot : slots) {
+            if (slot.index != Empty)
+                find(slot.key) = slot;
+        }
+    }
+
+    static std::size_t hash(const VertexKey &key)
+    {
+        // mix so that consecutive indices end up far apart
+        auto hash = static_cast<std::uint64_t>(static_cast<unsigned>(key.position)) * 0x9e3779b97f4a7c15ull;
+        hash ^= static_cast<std::uint64_t>(static_cast<unsigned>(key.texcoord)) * 0xc2b2ae3d27d4eb4full;
+        hash ^= static_cast<std::uint64_t>(static_cast<unsigned>(key.normal)) * 0x165667b19e3779f9ull;
+        return static_cast<std::size_t>(hash ^ (hash >> 32));
+    }
+
+    std::vector<Slot> m_slots; // size is a power of two
+    std::size_t m_size = 0;
+};
+
+bool isSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+// tokens of a single line, straight out of the source
+class LineParser
+{
+public:
+    explicit LineParser(std::string_view line)
+        : m_pos(line.data())
+        , m_end(line.data() + line.size())
+    {
+    }
+
+    bool atEnd()
+    {
+        skipSpaces();
+        return m_pos == m_end;
+    }
+
+    std::string_view word()
+    {
+        skipSpaces();
+        const auto *start = m_pos;
+        while (m_pos != m_end && !isSpace(*m_pos))
+            ++m_pos;
+        return { start, static_cast<std::size_t>(m_pos - start) };
+    }
+
+    template<typename T>
+    bool number(T &value)
+    {
+        skipSpaces();
+        if (m_pos != m_end && *m_pos == '+') // from_chars doesn't take it
+            ++m_pos;
+        const auto [ptr, ec] = std::from_chars(m_pos, m_end, value);
+        if (ec != std::errc())
+            return false;
+        m_pos = ptr;
+        return true;
+    }
+
+    template<typename Vector>
+    bool vector(Vector &value)
+    {
+        for (int i = 0; i < value.length(); ++i) {
+            if (!number(value[i]))
+                return false;
+        }
+        return true;
+    }
+
+    // one face corner, v, v/vt, v//vn or v/vt/vn; indices as given, 0 for the missing ones
+    bool corner(int &position, int &texcoord, int &normal)
+    {
+        texcoord = normal = 0;
+        if (!number(position))
+            return false;
+        if (consume('/')) {
+            if (!(peek('/') || number(texcoord)))
+                return false;
+            if (consume('/') && !number(normal))
+                return false;
+        }
+        return m_pos == m_end || isSpace(*m_pos);
+    }
+
+private:
+    void skipSpaces()
+    {
+        while (m_pos != m_end && isSpace(*m_pos))
+            ++m_pos;
+    }
+
+    bool peek(char c) const
+    {
+        return m_pos != m_end && *m_pos == c;
+    }
+
+    bool consume(char c)
+    {
+        if (!peek(c))
+            return false;
+        ++m_pos;
+        return true;
+    }
+
+    const char *m_pos;
+    const char *m_end;
+};
+
+// OBJ indices start at 1, negative ones count back from the last element so far
+bool resolveIndex(int index, std::size_t count, int &resolved)
+{
+    if (index > 0 && static_cast<std::size_t>(index) <= count) {
+        resolved = index - 1;
+        return true;
+    }
+    if (index < 0 && static_cast<std::size_t>(-index) <= count) {
+        resolved = static_cast<int>(count) + index;
+        return true;
+    }
+    return false;
+}
+
+} // namespace
+
+std::optional<ObjModel> parseObj(std::string_view source)
+{
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec2> texcoords;
+    std::vector<glm::vec3> normals;
+    std::vector<unsigned> face; // vertex indices of the face being parsed, reused for every face
+    VertexIndexTable vertexIndices;
+    ObjModel model;
+
+    // every face corner needs the vertex for its key, new if it wasn't seen before
+    const auto vertexIndex = [&](const VertexKey &key) {
+        const auto [index, inserted] = vertexIndices.insert(key, model.vertices.size());
+        if (inserted) {
+            auto &vertex = model.vertices.emplace_back();
+            vertex.position = positions[key.position];
+            vertex.texcoord = key.texcoord != -1 ? texcoords[key.texcoord] : glm::vec2(0);
+            vertex.normal = key.normal != -1 ? normals[key.normal] : glm::vec3(0);
+        }
+        return index;
+    };
+
+    while (!source.empty()) {
+        const auto lineEnd = std::min(source.find('\n'), source.size());
+        LineParser line(source.substr(0, lineEnd));
+        source.remove_prefix(std::min(lineEnd + 1, source.size()));
+
+        const auto keyword = line.word();
+        if (keyword == "v") {
+            if (!line.vector(positions.emplace_back()))
+                return std::nullopt;
+        } else if (keyword == "vt") {
+            if (!line.vector(texcoords.emplace_back()))
+                return std::nullopt;
+        } else if (keyword == "vn") {
+            if (!line.vector(normals.emplace_back()))
+                return std::nullopt;
+        } else if (keyword == "f") {
+            face.clear();
+            while (!line.atEnd()) {
+                int position, texcoord, normal;
+                if (!line.corner(position, texcoord, normal))
+                    return std::nullopt;
+                VertexKey key { -1, -1, -1 };
+                if (!resolveIndex(position, positions.size(), key.position))
+                    return std::nullopt;
+                if (texcoord != 0 && !resolveIndex(texcoord, texcoords.size(), key.texcoord))
+                    return std::nullopt;
+                if (normal != 0 && !resolveIndex(normal, normals.size(), key.normal))
+                    return std::nullopt;
+                face.push_back(vertexIndex(key));
+            }
+            if (face.size() < 3)
+                return std::nullopt;
+            for (std::size_t i = 1; i < face.size() - 1; ++i) {
+                model.indices.push_back(face[0]);
+                model.indices.push_back(face[i]);
+                model.indices.push_back(face[i + 1]);
+            }
+        }
+    }
+
+    return model;
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <optional>
+#include <string_view>
+#include <vector>
+
+// Triangles of a Wavefront OBJ model, indexed: each distinct combination of position, texcoord and
+// normal referenced by the faces is a single vertex. Polygons are split into triangle fans. Only
+// v, vt, vn and f are looked at; missing texcoords or normals are left as zero.
+struct ObjModel {
+    struct Vertex {
+        glm::vec3 position;
+        glm::vec2 texcoord;
+        glm::vec3 normal;
+    };
+    std::vector<Vertex> vertices;
+    std::vector<unsigned> indices;
+};
+
+// parses the whole source in place, without allocating per line; nullopt if it's malformed
+std::optional<ObjModel> parseObj(std::string_view source);
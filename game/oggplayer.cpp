@@ -20,10 +20,19 @@ OggPlayer::~OggPlayer()
 
 bool OggPlayer::open(const std::string &path)
 {
+    close();
+
+    m_file = GX::VFS::File(path);
+    if (!m_file) {
+        spdlog::error("Failed to open vorbis file {}", path);
+        return false;
+    }
+
     int error = 0;
-    m_vorbis = stb_vorbis_open_filename(path.c_str(), &error, nullptr);
+    m_vorbis = stb_vorbis_open_memory(m_file.data(), static_cast<int>(m_file.size()), &error, nullptr);
     if (!m_vorbis) {
         spdlog::error("Failed to open vorbis file {}: {}", path, error);
+        m_file = {};
         return false;
     }
 
@@ -46,6 +55,7 @@ void OggPlayer::close()
         stb_vorbis_close(m_vorbis);
         m_vorbis = nullptr;
     }
+    m_file = {};
 }
 
 void OggPlayer::play()
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <gx/noncopyable.h>
+#include <gx/vfs.h>
 
 #include <AL/al.h>
 
@@ -54,6 +55,7 @@ private:
 
     void loadAndQueueBuffer(Buffer &buffer);
 
+    GX::VFS::File m_file; // stb_vorbis decodes straight from the mapping
     stb_vorbis *m_vorbis = nullptr;
     unsigned m_channels;
     unsigned m_sampleRate;
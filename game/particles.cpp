@@ -0,0 +1,101 @@
+#include "particles.h"
+
+#include "simd.h"
+#include "tween.h"
+
+namespace {
+
+// values[i] += scale * deltas[i]
+void integrate(float *values, const float *deltas, float scale, std::size_t count)
+{
+    std::size_t i = 0;
+#ifdef HAVE_SSE
+    const auto s = _mm_set1_ps(scale);
+    for (; i + 4 <= count; i += 4) {
+        const auto v = _mm_loadu_ps(values + i);
+        const auto d = _mm_loadu_ps(deltas + i);
+        _mm_storeu_ps(values + i, _mm_add_ps(v, _mm_mul_ps(s, d)));
+    }
+#endif
+    for (; i < count; ++i)
+        values[i] += scale * deltas[i];
+}
+
+// values[i] += delta
+void advance(float *values, float delta, std::size_t count)
+{
+    std::size_t i = 0;
+#ifdef HAVE_SSE
+    const auto d = _mm_set1_ps(delta);
+    for (; i + 4 <= count; i += 4) {
+        _mm_storeu_ps(values + i, _mm_add_ps(_mm_loadu_ps(values + i), d));
+    }
+#endif
+    for (; i < count; ++i)
+        values[i] += delta;
+}
+
+} // namespace
+
+Particles::Particles(std::size_t capacity)
+    : m_capacity(capacity)
+{
+    for (auto *attribute : { &m_positionX, &m_positionY, &m_positionZ, &m_velocityX, &m_velocityY, &m_velocityZ, &m_sizeX, &m_sizeY, &m_time, &m_life })
+        attribute->resize(m_capacity);
+}
+
+void Particles::update(float elapsed)
+{
+    const auto count = m_size;
+    advance(m_time.data(), elapsed, count);
+    integrate(m_positionX.data(), m_velocityX.data(), elapsed, count);
+    integrate(m_positionY.data(), m_velocityY.data(), elapsed, count);
+    integrate(m_positionZ.data(), m_velocityZ.data(), elapsed, count);
+
+    std::size_t i = 0;
+    while (i < m_size) {
+        if (m_time[i] >= m_life[i]) {
+            remove(i);
+        } else {
+            ++i;
+        }
+    }
+}
+
+void Particles::remove(std::size_t index)
+{
+    // order doesn't matter, move the last particle into the hole
+    const auto last = --m_size;
+    for (auto *attribute : { &m_positionX, &m_positionY, &m_positionZ, &m_velocityX, &m_velocityY, &m_velocityZ, &m_sizeX, &m_sizeY, &m_time, &m_life })
+        (*attribute)[index] = (*attribute)[last];
+}
+
+void Particles::spawn(const glm::vec3 &position, const glm::vec3 &velocity, const glm::vec2 &size, float lifetime)
+{
+    if (m_size >= m_capacity)
+        return;
+    const auto index = m_size++;
+    m_positionX[index] = position.x;
+    m_positionY[index] = position.y;
+    m_positionZ[index] = position.z;
+    m_velocityX[index] = velocity.x;
+    m_velocityY[index] = velocity.y;
+    m_velocityZ[index] = velocity.z;
+    m_sizeX[index] = size.x;
+    m_sizeY[index] = size.y;
+    m_time[index] = 0;
+    m_life[index] = lifetime;
+}
+
+void Particles::writeVertices(Vertex *vertices) const
+{
+    const Tweeners::InOutQuadratic<float> tweener;
+    for (std::size_t i = 0; i < m_size; ++i) {
+        const float t = m_time[i] / m_life[i];
+        auto &vertex = vertices[i];
+        vertex.position = glm::vec3(m_positionX[i], m_positionY[i], m_positionZ[i]);
+        vertex.velocity = glm::vec3(m_velocityX[i], m_velocityY[i], m_velocityZ[i]);
+        vertex.size = glm::vec2(m_sizeX[i], m_sizeY[i]);
+        vertex.alpha = .25f * tweener(t);
+    }
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <vector>
+
+// Particle state, without any GL. One array per attribute component, so update() can go through
+// them with SIMD; ParticleSystem streams them to the GPU through writeVertices().
+class Particles
+{
+public:
+    struct Vertex {
+        glm::vec3 position;
+        glm::vec3 velocity;
+        glm::vec2 size;
+        float alpha;
+    };
+
+    explicit Particles(std::size_t capacity);
+
+    void update(float elapsed);
+    void spawn(const glm::vec3 &position, const glm::vec3 &velocity, const glm::vec2 &size, float lifetime); // ignored when full
+
+    // writes size() vertices
+    void writeVertices(Vertex *vertices) const;
+
+    std::size_t size() const { return m_size; }
+    std::size_t capacity() const { return m_capacity; }
+
+private:
+    void remove(std::size_t index);
+
+    std::size_t m_capacity;
+    std::size_t m_size = 0;
+    std::vector<float> m_positionX, m_positionY, m_positionZ;
+    std::vector<float> m_velocityX, m_velocityY, m_velocityZ;
+    std::vector<float> m_sizeX, m_sizeY;
+    std::vector<float> m_time;
+    std::vector<float> m_life;
+};
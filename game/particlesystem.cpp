@@ -1,112 +1,180 @@
 #include "particlesystem.h"
 
-#include "camera.h"
 #include "material.h"
-#include "mesh.h"
-#include "tween.h"
+#include "shadermanager.h"
 
 #include <gx/texture.h>
 
+#include <spdlog/spdlog.h>
+
 #include <algorithm>
 
 using namespace std::string_literals;
 
 namespace {
-struct ParticleState {
-    glm::vec3 position;
-    glm::vec3 velocity;
-    glm::vec2 size;
-    float alpha;
-};
 
-constexpr auto MaxParticles = 200;
+constexpr GLuint64 RegionFenceTimeout = 100'000'000; // nanoseconds
 
 const GX::GL::Texture *particleTexture()
 {
     static const GX::GL::Texture *texture = cachedTexture("star.png"s);
     return texture;
 }
+
+// Blocks until the GPU is done with whatever came before fence. Commands are flushed so the fence
+// gets signalled even if nothing else flushes them; if the wait fails, wait for everything.
+void waitForFence(GLsync fence)
+{
+    for (;;) {
+        switch (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, RegionFenceTimeout)) {
+        case GL_ALREADY_SIGNALED:
+        case GL_CONDITION_SATISFIED:
+            return;
+        case GL_TIMEOUT_EXPIRED:
+            break;
+        case GL_WAIT_FAILED:
+        default:
+            spdlog::warn("Failed to wait for particle buffer fence: 0x{:x}", glGetError());
+            glFinish();
+            return;
+        }
+    }
+}
+
 } // namespace
 
-ParticleSystem::ParticleSystem(ShaderManager *shaderManager, const Camera *camera)
+ParticleSystem::ParticleSystem(ShaderManager *shaderManager, std::size_t maxParticles)
     : m_shaderManager(shaderManager)
-    , m_camera(camera)
+    , m_particles(maxParticles)
 {
-    initializeMesh();
+    initializeBuffer();
 }
 
-ParticleSystem::~ParticleSystem() = default;
+ParticleSystem::~ParticleSystem()
+{
+    for (auto fence : m_regionFences) {
+        if (fence)
+            glDeleteSync(fence);
+    }
+    if (m_mappedVertices) {
+        glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+    }
+    glDeleteTextures(1, &m_vertexTexture);
+    glDeleteBuffers(1, &m_vertexBuffer);
+    glDeleteVertexArrays(1, &m_vertexArray);
+}
 
 void ParticleSystem::update(float elapsed)
 {
-    auto it = m_particles.begin();
-    while (it != m_particles.end()) {
-        auto &particle = *it;
-        particle.time += elapsed;
-        if (particle.time >= particle.life) {
-            it = m_particles.erase(it);
-        } else {
-            particle.position += elapsed * particle.velocity;
-            ++it;
-        }
-    }
+    m_particles.update(elapsed);
 }
 
-void ParticleSystem::render(const glm::mat4 &worldMatrix) const
+void ParticleSystem::render(const glm::mat4 &worldMatrix)
 {
-    if (m_particles.empty())
+    if (m_particles.size() == 0)
         return;
 
-    std::vector<ParticleState> particleData;
-    std::transform(m_particles.begin(), m_particles.end(), std::back_inserter(particleData), [](const Particle &particle) -> ParticleState {
-        const float t = particle.time / particle.life;
-        float alpha = .25f * Tweeners::InOutQuadratic<float>()(t);
-        return { particle.position, particle.velocity, particle.size, alpha };
-    });
-    m_mesh->setVertexCount(m_particles.size());
-    m_mesh->setVertexData(particleData.data());
+    if (auto &fence = m_regionFences[m_region]) {
+        waitForFence(fence);
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+
+    const auto first = m_region * m_particles.capacity();
+    if (m_mappedVertices) {
+        m_particles.writeVertices(m_mappedVertices + first);
+    } else {
+        glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
+        auto *vertices = glMapBufferRange(GL_ARRAY_BUFFER, first * sizeof(ParticleVertex), m_particles.size() * sizeof(ParticleVertex),
+                                          GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+        if (!vertices) {
+            spdlog::warn("Failed to map particle buffer: 0x{:x}", glGetError());
+            return;
+        }
+        m_particles.writeVertices(static_cast<ParticleVertex *>(vertices));
+        if (!glUnmapBuffer(GL_ARRAY_BUFFER)) { // the store was lost while mapped
+            spdlog::warn("Particle buffer contents were lost, skipping a frame");
+            return;
+        }
+    }
 
     glEnable(GL_BLEND);
     glBlendFunc(GL_ONE, GL_ONE);
 
     glDepthMask(GL_FALSE); // disable writing to depth buffer
 
-    m_shaderManager->useProgram(ShaderManager::Billboard);
-    m_shaderManager->setUniform(ShaderManager::ProjectionMatrix, m_camera->projectionMatrix());
-    m_shaderManager->setUniform(ShaderManager::ViewMatrix, m_camera->viewMatrix());
+    const auto program = m_billboardMode == BillboardMode::GeometryShader ? ShaderManager::Billboard : ShaderManager::BillboardInstanced;
+    m_shaderManager->useProgram(program);
     m_shaderManager->setUniform(ShaderManager::ModelMatrix, worldMatrix);
-    m_shaderManager->setUniform(ShaderManager::ModelViewMatrix, m_camera->viewMatrix() * worldMatrix);
-    m_shaderManager->setUniform(ShaderManager::ModelViewProjection, m_camera->projectionMatrix() * m_camera->viewMatrix() * worldMatrix);
     const auto normalMatrix = glm::transpose(glm::inverse(glm::mat3(worldMatrix)));
     m_shaderManager->setUniform(ShaderManager::NormalMatrix, normalMatrix);
 
     particleTexture()->bind();
 
-    m_mesh->render();
+    glBindVertexArray(m_vertexArray);
+    if (m_billboardMode == BillboardMode::GeometryShader) {
+        glDrawArrays(GL_POINTS, first, m_particles.size());
+    } else {
+        m_shaderManager->setUniform(ShaderManager::BaseInstance, static_cast<int>(first));
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_BUFFER, m_vertexTexture);
+        glActiveTexture(GL_TEXTURE0);
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, m_particles.size());
+    }
+    glBindVertexArray(0);
+
+    m_regionFences[m_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    m_region = (m_region + 1) % BufferRegions;
 
     glDepthMask(GL_TRUE);
 }
 
 void ParticleSystem::spawnParticle(const glm::vec3 &position, const glm::vec3 &velocity, const glm::vec2 &size, float lifetime)
 {
-    if (m_particles.size() >= MaxParticles)
-        return;
-    m_particles.push_back({ position, velocity, size, 0, lifetime });
+    m_particles.spawn(position, velocity, size, lifetime);
 }
 
-void ParticleSystem::initializeMesh()
+void ParticleSystem::initializeBuffer()
 {
-    m_mesh = std::make_unique<Mesh>(GL_POINTS);
+    const auto bufferSize = BufferRegions * m_particles.capacity() * sizeof(ParticleVertex);
+
+    glGenBuffers(1, &m_vertexBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
+    if (GLEW_ARB_buffer_storage) {
+        constexpr GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_ARRAY_BUFFER, bufferSize, nullptr, flags);
+        m_mappedVertices = static_cast<ParticleVertex *>(glMapBufferRange(GL_ARRAY_BUFFER, 0, bufferSize, flags));
+        if (!m_mappedVertices)
+            spdlog::warn("Failed to map particle buffer persistently, mapping it every frame: 0x{:x}", glGetError());
+    } else {
+        glBufferData(GL_ARRAY_BUFFER, bufferSize, nullptr, GL_STREAM_DRAW);
+    }
 
-    static const std::vector<Mesh::VertexAttribute> attributes = {
-        { 3, GL_FLOAT, offsetof(ParticleState, position) },
-        { 3, GL_FLOAT, offsetof(ParticleState, velocity) },
-        { 2, GL_FLOAT, offsetof(ParticleState, size) },
-        { 1, GL_FLOAT, offsetof(ParticleState, alpha) }
+    static_assert(sizeof(ParticleVertex) == 3 * sizeof(glm::vec3), "billboardquad.vert expects three RGB32F texels per particle");
+    glGenTextures(1, &m_vertexTexture);
+    glBindTexture(GL_TEXTURE_BUFFER, m_vertexTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGB32F, m_vertexBuffer);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+
+    struct VertexAttribute {
+        unsigned componentCount;
+        unsigned offset;
+    };
+    static const std::vector<VertexAttribute> attributes = {
+        { 3, offsetof(ParticleVertex, position) },
+        { 3, offsetof(ParticleVertex, velocity) },
+        { 2, offsetof(ParticleVertex, size) },
+        { 1, offsetof(ParticleVertex, alpha) }
     };
 
-    m_mesh->setVertexCount(MaxParticles);
-    m_mesh->setVertexSize(sizeof(ParticleState));
-    m_mesh->setVertexAttributes(attributes);
-    m_mesh->initialize();
+    glGenVertexArrays(1, &m_vertexArray);
+    glBindVertexArray(m_vertexArray);
+    int index = 0;
+    for (const auto &attribute : attributes) {
+        glEnableVertexAttribArray(index);
+        glVertexAttribPointer(index, attribute.componentCount, GL_FLOAT, GL_FALSE, sizeof(ParticleVertex), reinterpret_cast<GLvoid *>(attribute.offset));
+        ++index;
+    }
+    glBindVertexArray(0);
 }
@@ -1,38 +1,56 @@
 #pragma once
 
+#include "particles.h"
+
+#include <gx/noncopyable.h>
+
+#include <GL/glew.h>
 #include <glm/glm.hpp>
 
+#include <array>
 #include <memory>
 #include <vector>
 
-class Camera;
-class Mesh;
 class ShaderManager;
 
-class ParticleSystem
+class ParticleSystem : private GX::NonCopyable
 {
 public:
-    explicit ParticleSystem(ShaderManager *shaderManager, const Camera *camera);
+    static constexpr auto DefaultMaxParticles = 200;
+
+    explicit ParticleSystem(ShaderManager *shaderManager, std::size_t maxParticles = DefaultMaxParticles);
     ~ParticleSystem();
 
     void update(float elapsed);
-    void render(const glm::mat4 &worldMatrix) const;
+    void render(const glm::mat4 &worldMatrix);
 
     void spawnParticle(const glm::vec3 &position, const glm::vec3 &velocity, const glm::vec2 &size, float lifetime);
 
-private:
-    void initializeMesh();
-
-    struct Particle {
-        glm::vec3 position;
-        glm::vec3 velocity;
-        glm::vec2 size;
-        float time;
-        float life;
+    enum class BillboardMode {
+        GeometryShader, // points expanded to quads in a geometry shader
+        InstancedQuads, // instanced quads pulling particle data from a buffer texture
     };
+    void setBillboardMode(BillboardMode mode) { m_billboardMode = mode; }
+    BillboardMode billboardMode() const { return m_billboardMode; }
+
+    std::size_t particleCount() const { return m_particles.size(); }
+    std::size_t maxParticles() const { return m_particles.capacity(); }
+
+private:
+    using ParticleVertex = Particles::Vertex;
+    void initializeBuffer();
 
     ShaderManager *m_shaderManager;
-    const Camera *m_camera;
-    std::vector<Particle> m_particles;
-    std::unique_ptr<Mesh> m_mesh;
+    Particles m_particles;
+
+    // vertex buffer is split in regions written on successive frames, so we don't write
+    // over vertices the GPU may still be reading
+    static constexpr auto BufferRegions = 3;
+    GLuint m_vertexBuffer = 0;
+    GLuint m_vertexArray = 0;
+    GLuint m_vertexTexture = 0; // m_vertexBuffer as a buffer texture, for BillboardMode::InstancedQuads
+    ParticleVertex *m_mappedVertices = nullptr; // persistently mapped, if ARB_buffer_storage is available
+    std::array<GLsync, BufferRegions> m_regionFences = {};
+    int m_region = 0;
+    BillboardMode m_billboardMode = BillboardMode::GeometryShader;
 };
@@ -0,0 +1,159 @@
+#include "pathgenerator.h"
+
+#include "bezier.h"
+#include "pathtable.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+constexpr auto ChunkLength = 5.0f;
+constexpr auto ChunkLevels = 3; // 8 control points per chunk, as dense as the old fixed 20 unit track
+
+// Start of a part, looked up once for all the ends tried for it.
+struct PartStart {
+    PartStart(const Bezier &curve, const BezierArcLength &arcLength, float distance)
+        : distance(distance)
+    {
+        const auto t = arcLength.parameter(distance);
+        point = curve.eval(t);
+        direction = glm::normalize(curve.direction(t));
+    }
+
+    float distance;
+    glm::vec3 point;
+    glm::vec3 direction;
+};
+
+// A single straight part from start to distance to along curve is close enough to it if the direction
+// turns by at most MaxPartAngle and the curve strays at most MaxPartDeviation from the chord. The old
+// fixed 20 parts per curve strayed about as much, and turned by more than that for one part in a
+// hundred.
+bool partFits(const Bezier &curve, const BezierArcLength &arcLength, const PartStart &start, float to)
+{
+    constexpr auto MaxPartAngle = 0.14f; // radians
+    constexpr auto MaxPartDeviation = 0.001f;
+
+    const auto t = arcLength.parameter(to);
+    static const auto minCosAngle = std::cos(MaxPartAngle);
+    if (glm::dot(start.direction, glm::normalize(curve.direction(t))) < minCosAngle)
+        return false;
+
+    // a quadratic curve turns one way only, so it strays the most around the middle
+    const auto chord = curve.eval(t) - start.point;
+    const auto mid = curve.eval(arcLength.parameter(0.5f * (start.distance + to))) - start.point;
+    const auto chordLength2 = glm::dot(chord, chord);
+    const auto offset = chordLength2 > 0.0f ? mid - (glm::dot(mid, chord) / chordLength2) * chord : mid;
+    return glm::length(offset) <= MaxPartDeviation;
+}
+
+// Appends the distances along curve of the path parts covering it, each one the longest that still
+// fits, so the number of parts follows the curvature and nearly straight curves only get a few.
+void tessellateCurve(std::vector<float> &distances, const Bezier &curve, const BezierArcLength &arcLength)
+{
+    constexpr auto Bisections = 10;
+    constexpr auto MinPartLength = 0.005f; // around a cusp not even that fits, but parts must stay apart in float
+
+    const auto length = arcLength.length();
+    float from = 0.0f;
+    do {
+        distances.push_back(from);
+        const PartStart start(curve, arcLength, from);
+        if (partFits(curve, arcLength, start, length))
+            break;
+        // the longest part that fits is somewhere between nothing and the rest of the curve
+        float fits = 0.0f;
+        float doesNotFit = length - from;
+        for (int i = 0; i < Bisections; ++i) {
+            const auto mid = 0.5f * (fits + doesNotFit);
+            if (partFits(curve, arcLength, start, from + mid))
+                fits = mid;
+            else
+                doesNotFit = mid;
+        }
+        from += std::max(fits, MinPartLength);
+    } while (from < length - MinPartLength);
+}
+
+} // namespace
+
+PathGenerator::PathGenerator(unsigned seed)
+{
+    reset(seed);
+}
+
+void PathGenerator::reset(unsigned seed)
+{
+    m_random.seed(seed);
+    m_chunkStart = glm::vec3(0);
+    m_controlPoints.clear();
+    m_currentUp = glm::vec3(0, 0, 1);
+    m_distance = 0.0f;
+}
+
+float PathGenerator::random(float min, float max)
+{
+    return std::uniform_real_distribution<float>(min, max)(m_random);
+}
+
+void PathGenerator::subdivide(const glm::vec3 &from, const glm::vec3 &to, int level)
+{
+    if (level == 0) {
+        m_controlPoints.push_back(from);
+        return;
+    }
+
+    const auto dist = glm::distance(to, from);
+    const auto perturb = random(0.25f, .5f) * dist;
+
+    // perturb midpoint along a random vector orthogonal to the segment direction
+    const auto dir = glm::normalize(to - from);
+    std::normal_distribution<float> normal;
+    const auto side = glm::normalize(glm::vec3(normal(m_random), normal(m_random), normal(m_random)));
+    const auto up = glm::normalize(glm::cross(dir, side));
+
+    const auto mid = 0.5f * (from + to) + perturb * up;
+
+    subdivide(from, mid, level - 1);
+    subdivide(mid, to, level - 1);
+}
+
+void PathGenerator::generateChunk(PathTable &path)
+{
+    const auto chunkEnd = m_chunkStart + glm::vec3(ChunkLength, 0, 0);
+    subdivide(m_chunkStart, chunkEnd, ChunkLevels);
+    m_chunkStart = chunkEnd;
+
+    // the curve around the last control point needs the next chunk's first one
+    for (std::size_t i = 1, size = m_controlPoints.size() - 1; i < size; ++i)
+        appendCurve(path, m_controlPoints[i - 1], m_controlPoints[i], m_controlPoints[i + 1]);
+    m_controlPoints.erase(m_controlPoints.begin(), m_controlPoints.end() - 2);
+}
+
+void PathGenerator::appendCurve(PathTable &path, const glm::vec3 &prev, const glm::vec3 &cur, const glm::vec3 &next)
+{
+    const auto curve = Bezier { 0.5f * (prev + cur), cur, 0.5f * (cur + next) };
+    const BezierArcLength arcLength(curve);
+
+    // the end of this curve is the start of the next one
+    m_partDistances.clear();
+    tessellateCurve(m_partDistances, curve, arcLength);
+
+    for (const auto partDistance : m_partDistances) {
+        const auto t = arcLength.parameter(partDistance);
+
+        const auto center = curve.eval(t);
+
+        const auto dir = glm::normalize(curve.direction(t));
+        const auto side = glm::normalize(glm::cross(dir, m_currentUp));
+        const auto up = glm::normalize(glm::cross(side, dir));
+
+        const auto orientation = glm::mat3(up, side, dir);
+
+        path.append({ orientation, center }, m_distance + partDistance);
+
+        m_currentUp = up;
+    }
+    m_distance += arcLength.length();
+}
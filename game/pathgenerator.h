@@ -0,0 +1,38 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <random>
+#include <vector>
+
+class PathTable;
+
+// Generates the path a chunk at a time, as far ahead as it's needed: each chunk is a straight
+// stretch with midpoints recursively pushed aside at random, then smoothed into curves through
+// the resulting control points. The same seed always gives the same path.
+class PathGenerator
+{
+public:
+    // how the path is used up: World generates it LookAhead seconds ahead of the camera, moving at
+    // Speed, and discards what's more than MarginBehind behind it
+    static constexpr auto Speed = 0.5f; // path distance per second
+    static constexpr auto LookAhead = 12.0f; // seconds, should cover the fog distance
+    static constexpr auto MarginBehind = 0.5f; // path distance behind the camera still rendered
+
+    explicit PathGenerator(unsigned seed = 0);
+
+    void reset(unsigned seed);
+    void generateChunk(PathTable &path); // appends the parts of the next chunk
+
+private:
+    void subdivide(const glm::vec3 &from, const glm::vec3 &to, int level);
+    void appendCurve(PathTable &path, const glm::vec3 &prev, const glm::vec3 &cur, const glm::vec3 &next);
+    float random(float min, float max);
+
+    std::mt19937 m_random;
+    glm::vec3 m_chunkStart;
+    std::vector<glm::vec3> m_controlPoints; // the last two are kept for the next chunk's first curve
+    glm::vec3 m_currentUp;
+    float m_distance; // at the start of the next curve
+    std::vector<float> m_partDistances;
+};
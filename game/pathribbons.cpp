@@ -0,0 +1,125 @@
+#include "pathribbons.h"
+
+#include "pathtable.h"
+#include "shadermanager.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+namespace {
+
+constexpr auto TexelsPerPart = 2; // see pathribbon.vert
+constexpr auto EndVertices = 8; // four pairs for each end of a ribbon
+
+} // namespace
+
+PathRibbons::PathRibbons(ShaderManager *shaderManager)
+    : m_shaderManager(shaderManager)
+{
+    glGenBuffers(1, &m_pathBuffer);
+    glGenTextures(1, &m_pathTexture); // attached to m_pathBuffer once that has storage, see updatePath
+
+    struct VertexAttribute {
+        unsigned componentCount;
+        unsigned offset;
+    };
+    static const std::vector<VertexAttribute> attributes = {
+        { 2, offsetof(Ribbon, startDistance) },
+        { 4, offsetof(Ribbon, offset) },
+        { 1, offsetof(Ribbon, textureRepeat) }
+    };
+
+    glGenBuffers(1, &m_ribbonBuffer);
+    glGenVertexArrays(1, &m_vertexArray);
+    glBindVertexArray(m_vertexArray);
+    glBindBuffer(GL_ARRAY_BUFFER, m_ribbonBuffer);
+    int index = 0;
+    for (const auto &attribute : attributes) {
+        glEnableVertexAttribArray(index);
+        glVertexAttribPointer(index, attribute.componentCount, GL_FLOAT, GL_FALSE, sizeof(Ribbon), reinterpret_cast<GLvoid *>(attribute.offset));
+        glVertexAttribDivisor(index, 1);
+        ++index;
+    }
+    glBindVertexArray(0);
+}
+
+PathRibbons::~PathRibbons()
+{
+    glDeleteVertexArrays(1, &m_vertexArray);
+    glDeleteBuffers(1, &m_ribbonBuffer);
+    glDeleteTextures(1, &m_pathTexture);
+    glDeleteBuffers(1, &m_pathBuffer);
+}
+
+void PathRibbons::updatePath(const PathTable &path)
+{
+    glBindBuffer(GL_TEXTURE_BUFFER, m_pathBuffer);
+
+    // same ring as the table, so a part stays where it was uploaded until the table grows
+    if (path.capacity() != m_pathCapacity) {
+        m_pathCapacity = path.capacity();
+        glBufferData(GL_TEXTURE_BUFFER, TexelsPerPart * m_pathCapacity * sizeof(glm::vec4), nullptr, GL_DYNAMIC_DRAW);
+        // some drivers keep the size the store had when the buffer was attached, so attach it again
+        glBindTexture(GL_TEXTURE_BUFFER, m_pathTexture);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, m_pathBuffer);
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+        m_uploadedEnd = path.firstIndex();
+    }
+    m_pathFirst = path.firstIndex() & (m_pathCapacity - 1);
+    m_pathSize = path.size();
+
+    // indices keep counting up, even across PathTable::clear
+    auto index = std::max(m_uploadedEnd, path.firstIndex());
+    const auto end = path.endIndex();
+    std::vector<glm::vec4> texels;
+    while (index < end) {
+        // parts up to the end of the ring at most, so they go in one contiguous range
+        const auto slot = index & (m_pathCapacity - 1);
+        const auto runEnd = std::min(end, index + m_pathCapacity - slot);
+        texels.clear();
+        for (; index < runEnd; ++index) {
+            const auto rotation = path.rotation(index);
+            texels.emplace_back(path.center(index), path.distance(index));
+            texels.emplace_back(rotation.x, rotation.y, rotation.z, rotation.w);
+        }
+        glBufferSubData(GL_TEXTURE_BUFFER, TexelsPerPart * slot * sizeof(glm::vec4), texels.size() * sizeof(glm::vec4), texels.data());
+    }
+    m_uploadedEnd = end;
+
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+void PathRibbons::setRibbonCount(std::size_t count)
+{
+    m_ribbonCapacity = count;
+    glBindBuffer(GL_ARRAY_BUFFER, m_ribbonBuffer);
+    glBufferData(GL_ARRAY_BUFFER, count * sizeof(Ribbon), nullptr, GL_DYNAMIC_DRAW);
+}
+
+void PathRibbons::setRibbons(std::size_t first, const Ribbon *ribbons, std::size_t count)
+{
+    assert(first + count <= m_ribbonCapacity);
+    glBindBuffer(GL_ARRAY_BUFFER, m_ribbonBuffer);
+    glBufferSubData(GL_ARRAY_BUFFER, first * sizeof(Ribbon), count * sizeof(Ribbon), ribbons);
+}
+
+void PathRibbons::render(std::size_t first, std::size_t count, std::size_t parts) const
+{
+    assert(first + count <= m_ribbonCapacity);
+    if (count == 0 || m_pathSize < 2)
+        return;
+
+    m_shaderManager->setUniform(ShaderManager::PathFirst, static_cast<int>(m_pathFirst));
+    m_shaderManager->setUniform(ShaderManager::PathSize, static_cast<int>(m_pathSize));
+    m_shaderManager->setUniform(ShaderManager::RibbonParts, static_cast<int>(parts));
+
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_BUFFER, m_pathTexture);
+    glActiveTexture(GL_TEXTURE0);
+
+    glBindVertexArray(m_vertexArray);
+    glDrawArraysInstancedBaseInstance(GL_TRIANGLE_STRIP, 0, EndVertices + 2 * parts + EndVertices, count, first);
+    glBindVertexArray(0);
+}
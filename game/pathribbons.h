@@ -0,0 +1,56 @@
+#pragma once
+
+#include <gx/noncopyable.h>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <cstddef>
+
+class ShaderManager;
+class PathTable;
+
+// Strips laid along the path, extruded in pathribbon.vert: the path is mirrored in a buffer texture
+// a part at a time as it gets generated, and each strip is just an instance with its extent along
+// the path and its profile, so nothing is rebuilt as the path goes by.
+class PathRibbons : private GX::NonCopyable
+{
+public:
+    explicit PathRibbons(ShaderManager *shaderManager);
+    ~PathRibbons();
+
+    struct Ribbon {
+        float startDistance;
+        float endDistance;
+        float offset; // from the path center, along its side
+        float halfWidth;
+        float bevel; // cut off the corners at both ends, 0 for square ends
+        float height; // above the path
+        float textureRepeat; // texture v coordinate per unit of distance, 0 for none
+    };
+
+    // uploads the parts appended since the last update; ribbons can only be drawn over the parts
+    // path still has
+    void updatePath(const PathTable &path);
+
+    void setRibbonCount(std::size_t count); // ribbons are undefined until set
+    void setRibbons(std::size_t first, const Ribbon *ribbons, std::size_t count);
+
+    // draws ribbons [first, first + count) with the current program, which should be one of the
+    // Ribbon ones; parts is the most path parts any of them covers, see PathTable::partCount
+    void render(std::size_t first, std::size_t count, std::size_t parts) const;
+
+private:
+    ShaderManager *m_shaderManager;
+
+    GLuint m_pathBuffer = 0;
+    GLuint m_pathTexture = 0;
+    std::size_t m_pathCapacity = 0; // of the PathTable ring mirrored in m_pathBuffer
+    std::size_t m_pathFirst = 0; // ring slot of the first part
+    std::size_t m_pathSize = 0;
+    std::size_t m_uploadedEnd = 0; // path index past the last part uploaded
+
+    GLuint m_ribbonBuffer = 0;
+    GLuint m_vertexArray = 0;
+    std::size_t m_ribbonCapacity = 0;
+};
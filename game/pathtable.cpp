@@ -0,0 +1,241 @@
+#include "pathtable.h"
+
+#include "simd.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtx/quaternion.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+glm::mat4 PathState::transformMatrix() const
+{
+    const auto translate = glm::translate(glm::mat4(1), center);
+    const auto rotation = glm::mat4(orientation);
+    return translate * rotation;
+}
+
+void PathTable::clear()
+{
+    m_first = m_end;
+}
+
+void PathTable::append(const PathState &state, float distance)
+{
+    auto rotation = glm::quat_cast(state.orientation);
+    // q and -q are the same rotation, pick the one that lerps the short way from the previous part
+    if (size() > 0) {
+        const auto last = slot(m_end - 1);
+        const auto prev = glm::quat(m_rotationW[last], m_rotationX[last], m_rotationY[last], m_rotationZ[last]);
+        if (glm::dot(prev, rotation) < 0.0f)
+            rotation = -rotation;
+    }
+    append(rotation, state.center, distance);
+}
+
+void PathTable::append(const glm::quat &rotation, const glm::vec3 &center, float distance)
+{
+    assert(size() == 0 || distance >= endDistance());
+    if (size() == capacity())
+        grow();
+
+    const auto index = m_end++ & (capacity() - 1);
+    m_distances[index] = distance;
+    m_centerX[index] = center.x;
+    m_centerY[index] = center.y;
+    m_centerZ[index] = center.z;
+    m_rotationX[index] = rotation.x;
+    m_rotationY[index] = rotation.y;
+    m_rotationZ[index] = rotation.z;
+    m_rotationW[index] = rotation.w;
+}
+
+// only happens while the window of parts kept is still finding its size
+void PathTable::grow()
+{
+    const auto oldMask = capacity() - 1; // capacity() changes as soon as m_distances is swapped
+    const auto newCapacity = capacity() == 0 ? InitialCapacity : 2 * capacity();
+    for (auto *component : { &m_distances, &m_centerX, &m_centerY, &m_centerZ, &m_rotationX, &m_rotationY, &m_rotationZ, &m_rotationW }) {
+        std::vector<float> values(newCapacity);
+        for (auto index = m_first; index < m_end; ++index)
+            values[index & (newCapacity - 1)] = (*component)[index & oldMask];
+        component->swap(values);
+    }
+}
+
+void PathTable::discardBefore(float distance)
+{
+    while (size() > 2 && m_distances[slot(m_first + 1)] <= distance)
+        ++m_first;
+}
+
+PathState PathTable::state(std::size_t index) const
+{
+    return { glm::mat3_cast(rotation(index)), center(index) };
+}
+
+glm::vec3 PathTable::center(std::size_t index) const
+{
+    const auto i = slot(index);
+    return glm::vec3(m_centerX[i], m_centerY[i], m_centerZ[i]);
+}
+
+glm::quat PathTable::rotation(std::size_t index) const
+{
+    const auto i = slot(index);
+    return glm::quat(m_rotationW[i], m_rotationX[i], m_rotationY[i], m_rotationZ[i]);
+}
+
+PathState PathTable::stateAt(float distance) const
+{
+    return interpolate(partIndex(distance), distance);
+}
+
+std::size_t PathTable::partCount(float from, float to) const
+{
+    return to < from ? 0 : upperBound(to) - upperBound(std::nextafter(from, -INFINITY));
+}
+
+// first part past distance, like std::upper_bound
+std::size_t PathTable::upperBound(float distance) const
+{
+    auto low = m_first;
+    auto high = m_end;
+    while (low < high) {
+        const auto mid = low + (high - low) / 2;
+        if (distance < m_distances[slot(mid)])
+            high = mid;
+        else
+            low = mid + 1;
+    }
+    return low;
+}
+
+// index of the part starting at or right before distance, so that parts index and index + 1 enclose it
+std::size_t PathTable::partIndex(float distance) const
+{
+    assert(size() >= 2);
+    const auto low = upperBound(distance);
+    if (low == m_first)
+        return m_first;
+    return std::min(low - 1, m_end - 2);
+}
+
+PathState PathTable::interpolate(std::size_t index, float distance) const
+{
+    const auto part = slot(index);
+    const auto next = slot(index + 1);
+    const float t = (distance - m_distances[part]) / (m_distances[next] - m_distances[part]);
+
+    const auto mix = [part, next, t](const std::vector<float> &values) {
+        return values[part] + t * (values[next] - values[part]);
+    };
+    const auto center = glm::vec3(mix(m_centerX), mix(m_centerY), mix(m_centerZ));
+    // consecutive parts are only slightly rotated, so normalized lerp is as good as slerp here
+    const auto rotation = glm::normalize(glm::quat(mix(m_rotationW), mix(m_rotationX), mix(m_rotationY), mix(m_rotationZ)));
+
+    return { glm::mat3_cast(rotation), center };
+}
+
+void PathTable::interpolate(const std::size_t *parts, const float *distances, std::size_t count, PathState *states) const
+{
+    std::size_t i = 0;
+#ifdef HAVE_SSE
+    for (; i + 4 <= count; i += 4) {
+        const auto load = [this, parts, i](const std::vector<float> &values, std::size_t offset) {
+            return _mm_setr_ps(values[slot(parts[i] + offset)], values[slot(parts[i + 1] + offset)], values[slot(parts[i + 2] + offset)], values[slot(parts[i + 3] + offset)]);
+        };
+
+        const auto d0 = load(m_distances, 0);
+        const auto t = _mm_div_ps(_mm_sub_ps(_mm_loadu_ps(distances + i), d0), _mm_sub_ps(load(m_distances, 1), d0));
+
+        const auto mix = [&load, t](const std::vector<float> &values) {
+            const auto v0 = load(values, 0);
+            return _mm_add_ps(v0, _mm_mul_ps(t, _mm_sub_ps(load(values, 1), v0)));
+        };
+        const auto x = mix(m_rotationX);
+        const auto y = mix(m_rotationY);
+        const auto z = mix(m_rotationZ);
+        const auto w = mix(m_rotationW);
+
+        // glm::mat3_cast of the unnormalized quaternion, with the products scaled by 2 / |q|^2 instead
+        const auto norm = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_add_ps(_mm_mul_ps(z, z), _mm_mul_ps(w, w)));
+        const auto s = _mm_div_ps(_mm_set1_ps(2.0f), norm);
+        const auto xs = _mm_mul_ps(x, s);
+        const auto ys = _mm_mul_ps(y, s);
+        const auto zs = _mm_mul_ps(z, s);
+        const auto xx = _mm_mul_ps(x, xs);
+        const auto yy = _mm_mul_ps(y, ys);
+        const auto zz = _mm_mul_ps(z, zs);
+        const auto xy = _mm_mul_ps(x, ys);
+        const auto xz = _mm_mul_ps(x, zs);
+        const auto yz = _mm_mul_ps(y, zs);
+        const auto wx = _mm_mul_ps(w, xs);
+        const auto wy = _mm_mul_ps(w, ys);
+        const auto wz = _mm_mul_ps(w, zs);
+        const auto one = _mm_set1_ps(1.0f);
+
+        alignas(16) float m[12][4];
+        _mm_store_ps(m[0], _mm_sub_ps(one, _mm_add_ps(yy, zz)));
+        _mm_store_ps(m[1], _mm_add_ps(xy, wz));
+        _mm_store_ps(m[2], _mm_sub_ps(xz, wy));
+        _mm_store_ps(m[3], _mm_sub_ps(xy, wz));
+        _mm_store_ps(m[4], _mm_sub_ps(one, _mm_add_ps(xx, zz)));
+        _mm_store_ps(m[5], _mm_add_ps(yz, wx));
+        _mm_store_ps(m[6], _mm_add_ps(xz, wy));
+        _mm_store_ps(m[7], _mm_sub_ps(yz, wx));
+        _mm_store_ps(m[8], _mm_sub_ps(one, _mm_add_ps(xx, yy)));
+        _mm_store_ps(m[9], mix(m_centerX));
+        _mm_store_ps(m[10], mix(m_centerY));
+        _mm_store_ps(m[11], mix(m_centerZ));
+
+        for (int j = 0; j < 4; ++j) {
+            auto &state = states[i + j];
+            state.orientation = glm::mat3(m[0][j], m[1][j], m[2][j], m[3][j], m[4][j], m[5][j], m[6][j], m[7][j], m[8][j]);
+            state.center = glm::vec3(m[9][j], m[10][j], m[11][j]);
+        }
+    }
+#endif
+    for (; i < count; ++i)
+        states[i] = interpolate(parts[i], distances[i]);
+}
+
+std::size_t PathTable::Cursor::partIndex(float distance)
+{
+    const auto &table = *m_table;
+    assert(table.size() >= 2);
+    // the table may have been cleared or moved past our part since the last lookup
+    if (m_part < table.firstIndex() || m_part + 1 >= table.endIndex() || distance < table.distance(m_part))
+        return m_part = table.partIndex(distance);
+
+    // usually the same part as last time, or the next one
+    constexpr auto MaxSteps = 8;
+    const auto lastPart = table.endIndex() - 2;
+    for (int steps = 0; m_part < lastPart && distance >= table.distance(m_part + 1); ++steps) {
+        if (steps == MaxSteps)
+            return m_part = table.partIndex(distance);
+        ++m_part;
+    }
+    return m_part;
+}
+
+PathState PathTable::Cursor::stateAt(float distance)
+{
+    return m_table->interpolate(partIndex(distance), distance);
+}
+
+// the parts are found a chunk at a time, so that they fit on the stack whatever the count
+void PathTable::Cursor::statesAt(const float *distances, std::size_t count, PathState *states)
+{
+    constexpr std::size_t ChunkSize = 64;
+    std::size_t parts[ChunkSize];
+    for (std::size_t first = 0; first < count; first += ChunkSize) {
+        const auto chunkSize = std::min(ChunkSize, count - first);
+        for (std::size_t i = 0; i < chunkSize; ++i) {
+            assert(first + i == 0 || distances[first + i] >= distances[first + i - 1]);
+            parts[i] = partIndex(distances[first + i]);
+        }
+        m_table->interpolate(parts, distances + first, chunkSize, states + first);
+    }
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+struct PathState {
+    glm::mat3 orientation;
+    glm::vec3 center;
+
+    glm::vec3 up() const { return orientation[0]; }
+    glm::vec3 side() const { return orientation[1]; }
+    glm::vec3 direction() const { return orientation[2]; }
+    glm::mat4 transformMatrix() const;
+};
+
+// Path sampled at increasing distances, stored as one array per component (orientations as
+// quaternions) so that in-between states can be interpolated four at a time with SSE.
+//
+// The arrays are a ring: parts are appended as the path is generated ahead and discarded once left
+// behind, so only a window of the path is kept. Parts are addressed by an index that keeps counting
+// up, valid in [firstIndex(), endIndex()).
+class PathTable
+{
+public:
+    void clear(); // indices keep counting up from where they were
+    void append(const PathState &state, float distance); // distance must not be less than the previous one
+    void discardBefore(float distance); // keeps the part distance falls in
+
+    std::size_t firstIndex() const { return m_first; }
+    std::size_t endIndex() const { return m_end; }
+    std::size_t size() const { return m_end - m_first; }
+    std::size_t capacity() const { return m_distances.size(); }
+    float distance(std::size_t index) const { return m_distances[slot(index)]; }
+    PathState state(std::size_t index) const;
+    glm::vec3 center(std::size_t index) const;
+    glm::quat rotation(std::size_t index) const;
+    float endDistance() const { return distance(m_end - 1); }
+
+    PathState stateAt(float distance) const;
+    std::size_t partCount(float from, float to) const; // parts in [from, to]
+
+    // Remembers the last part it found, so a sequence of increasing distances costs a few
+    // comparisons per lookup instead of a binary search. Going backwards is fine, just slower.
+    class Cursor
+    {
+    public:
+        explicit Cursor(const PathTable *table)
+            : m_table(table)
+        {
+        }
+
+        PathState stateAt(float distance);
+        // states[i] = stateAt(distances[i]), distances in increasing order
+        void statesAt(const float *distances, std::size_t count, PathState *states);
+
+    private:
+        std::size_t partIndex(float distance);
+
+        const PathTable *m_table;
+        std::size_t m_part = 0;
+    };
+
+private:
+    static constexpr std::size_t InitialCapacity = 1024; // a power of two, so are the ones after it
+
+    std::size_t slot(std::size_t index) const
+    {
+        assert(index >= m_first && index < m_end);
+        return index & (capacity() - 1);
+    }
+    void append(const glm::quat &rotation, const glm::vec3 &center, float distance);
+    void grow();
+    std::size_t upperBound(float distance) const;
+    std::size_t partIndex(float distance) const;
+    PathState interpolate(std::size_t part, float distance) const;
+    void interpolate(const std::size_t *parts, const float *distances, std::size_t count, PathState *states) const;
+
+    std::size_t m_first = 0;
+    std::size_t m_end = 0;
+    std::vector<float> m_distances;
+    std::vector<float> m_centerX, m_centerY, m_centerZ;
+    std::vector<float> m_rotationX, m_rotationY, m_rotationZ, m_rotationW; // consecutive ones in the same hemisphere
+};
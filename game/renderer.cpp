@@ -3,22 +3,139 @@
 #include <gx/shaderprogram.h>
 #include <gx/texture.h>
 
+#include "instanceculler.h"
 #include "material.h"
 #include "mesh.h"
 #include "shadermanager.h"
+#include "simd.h"
+#include "transparencypass.h"
 
 #include <spdlog/spdlog.h>
 
 #include <algorithm>
+#include <array>
+#include <cassert>
+#include <iterator>
 #include <optional>
 
-Renderer::Renderer(ShaderManager *shaderManager, const Camera *camera)
+namespace {
+
+// Inverse transpose of the upper 3x3 of each model matrix. With columns a, b, c the inverse transpose
+// has columns (b x c, c x a, a x b) / det, det = a . (b x c); four instances are done at a time.
+void computeNormalMatrices(MeshInstance *instances, std::size_t count)
+{
+    std::size_t i = 0;
+#ifdef HAVE_SSE
+    const auto cross = [](__m128 ux, __m128 uy, __m128 uz, __m128 vx, __m128 vy, __m128 vz, __m128 *rx, __m128 *ry, __m128 *rz) {
+        *rx = _mm_sub_ps(_mm_mul_ps(uy, vz), _mm_mul_ps(uz, vy));
+        *ry = _mm_sub_ps(_mm_mul_ps(uz, vx), _mm_mul_ps(ux, vz));
+        *rz = _mm_sub_ps(_mm_mul_ps(ux, vy), _mm_mul_ps(uy, vx));
+    };
+    for (; i + 4 <= count; i += 4) {
+        auto *m = instances + i;
+        const auto load = [m](int column, int row) {
+            return _mm_setr_ps(m[0].modelMatrix[column][row], m[1].modelMatrix[column][row], m[2].modelMatrix[column][row], m[3].modelMatrix[column][row]);
+        };
+        const auto ax = load(0, 0), ay = load(0, 1), az = load(0, 2);
+        const auto bx = load(1, 0), by = load(1, 1), bz = load(1, 2);
+        const auto cx = load(2, 0), cy = load(2, 1), cz = load(2, 2);
+
+        __m128 n0x, n0y, n0z, n1x, n1y, n1z, n2x, n2y, n2z;
+        cross(bx, by, bz, cx, cy, cz, &n0x, &n0y, &n0z);
+        cross(cx, cy, cz, ax, ay, az, &n1x, &n1y, &n1z);
+        cross(ax, ay, az, bx, by, bz, &n2x, &n2y, &n2z);
+        const auto det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, n0x), _mm_mul_ps(ay, n0y)), _mm_mul_ps(az, n0z));
+        const auto invDet = _mm_div_ps(_mm_set1_ps(1.0f), det);
+
+        const auto store = [m, invDet](int column, int row, __m128 value) {
+            alignas(16) float values[4];
+            _mm_store_ps(values, _mm_mul_ps(value, invDet));
+            for (int j = 0; j < 4; ++j)
+                m[j].normalMatrix[column][row] = values[j];
+        };
+        store(0, 0, n0x), store(0, 1, n0y), store(0, 2, n0z);
+        store(1, 0, n1x), store(1, 1, n1y), store(1, 2, n1z);
+        store(2, 0, n2x), store(2, 1, n2y), store(2, 2, n2z);
+    }
+#endif
+    for (; i < count; ++i) {
+        auto &instance = instances[i];
+        instance.normalMatrix = glm::transpose(glm::inverse(glm::mat3(instance.modelMatrix)));
+    }
+}
+
+// Sort key, from the most significant bits down, all 64 bits used:
+//   2 bits  blend bucket (solid, transparent, additive)
+//   6 bits  program (ShaderManager::NumPrograms <= 64)
+//  16 bits  material id (65536 materials created)
+//  24 bits  mesh id (16M meshes created, ids aren't reused)
+//  16 bits  depth, front to back
+// Ids that don't fit would alias other materials or meshes and break up instanced runs, render()
+// asserts they don't. Neither transparent (order-independent, see TransparencyPass) nor additive
+// draws depend on order, so all buckets group by mesh for longer instanced runs.
+enum class Bucket : std::uint64_t {
+    Solid,
+    Transparent,
+    Additive,
+};
+constexpr auto BucketShift = 62;
+constexpr auto ProgramShift = 56;
+constexpr auto MaterialShift = 40;
+constexpr auto MeshShift = 16;
+constexpr auto DepthShift = 0;
+constexpr std::uint64_t MaterialMask = 0xffff;
+constexpr std::uint64_t MeshMask = 0xffffff;
+constexpr std::uint64_t DepthMask = 0xffff;
+static_assert(ShaderManager::NumPrograms <= 64, "program doesn't fit in the sort key");
+
+Bucket bucket(const Material *material)
+{
+    if (material->flags == Material::None)
+        return Bucket::Solid;
+    if (material->flags & Material::Transparent)
+        return Bucket::Transparent;
+    return Bucket::Additive;
+}
+
+// stable LSD radix sort, one byte at a time; bytes that are the same in every key are skipped
+template<typename Item>
+void radixSort(std::vector<Item> &items, std::vector<Item> &scratch)
+{
+    scratch.resize(items.size());
+    for (int shift = 0; shift < 64; shift += 8) {
+        std::array<std::size_t, 256> counts = {};
+        for (const auto &item : items)
+            ++counts[(item.key >> shift) & 0xff];
+        if (std::find(counts.begin(), counts.end(), items.size()) != counts.end())
+            continue;
+        std::size_t offset = 0;
+        for (auto &count : counts) {
+            const auto bucketSize = count;
+            count = offset;
+            offset += bucketSize;
+        }
+        for (const auto &item : items)
+            scratch[counts[(item.key >> shift) & 0xff]++] = item;
+        items.swap(scratch);
+    }
+}
+
+} // namespace
+
+Renderer::Renderer(ShaderManager *shaderManager, const Camera *camera, TransparencyPass *transparencyPass)
     : m_shaderManager(shaderManager)
     , m_camera(camera)
+    , m_transparencyPass(transparencyPass)
 {
+    glGenBuffers(1, &m_instanceBuffer);
+    glGenBuffers(1, &m_indirectBuffer);
 }
 
-Renderer::~Renderer() = default;
+Renderer::~Renderer()
+{
+    glDeleteBuffers(1, &m_indirectBuffer);
+    glDeleteBuffers(1, &m_instanceBuffer);
+}
 
 void Renderer::resize(int width, int height)
 {
@@ -29,36 +146,97 @@ void Renderer::resize(int width, int height)
 void Renderer::begin()
 {
     m_drawCalls.clear();
+    m_culledInstances.clear();
 }
 
 void Renderer::render(const Mesh *mesh, const Material *material, const glm::mat4 &worldMatrix)
 {
-    m_drawCalls.push_back({ mesh, material, worldMatrix });
+    const auto drawBucket = bucket(material);
+
+    // view space depth of the mesh origin, quantized over the camera range
+    const auto viewZ = -(m_camera->viewMatrix() * worldMatrix[3]).z;
+    const auto depth = static_cast<std::uint64_t>(DepthMask * glm::clamp(viewZ / m_camera->zFar(), 0.0f, 1.0f));
+
+    assert(material->id <= MaterialMask);
+    assert(mesh->id() <= MeshMask);
+    const auto sortKey = (static_cast<std::uint64_t>(drawBucket) << BucketShift)
+        | (static_cast<std::uint64_t>(material->program) << ProgramShift)
+        | ((material->id & MaterialMask) << MaterialShift)
+        | ((mesh->id() & MeshMask) << MeshShift)
+        | (depth << DepthShift);
+
+    m_drawCalls.push_back({ sortKey, mesh, material, worldMatrix });
 }
 
-template<typename Iterator>
-void Renderer::render(Iterator first, Iterator last) const
+void Renderer::render(const InstanceCuller *instances)
 {
-    std::stable_sort(first, last, [](const auto &lhs, const auto &rhs) {
-        return std::tie(lhs.material->program, lhs.material->texture) < std::tie(rhs.material->program, rhs.material->texture);
+    m_culledInstances.push_back(instances);
+}
+
+// one indirect command per run of draw calls sharing mesh and material, and runs that only differ
+// by mesh go in the same batch as long as their meshes can be drawn together; then a batch for each
+// group of GPU culled instances, whose commands are already in their own buffer
+void Renderer::buildBatches()
+{
+    m_drawCommands.clear();
+    m_drawBatches.clear();
+
+    auto it = m_drawCalls.begin();
+    while (it != m_drawCalls.end()) {
+        const auto &drawCall = *it;
+        const auto runEnd = std::find_if(std::next(it), m_drawCalls.end(), [&drawCall](const DrawCall &other) {
+            return other.mesh != drawCall.mesh || other.material != drawCall.material;
+        });
+
+        const auto *mesh = drawCall.mesh;
+        const auto instanceCount = std::distance(it, runEnd);
+        const auto baseInstance = std::distance(m_drawCalls.begin(), it);
+        m_drawCommands.push_back(mesh->drawCommand(instanceCount, baseInstance));
+
+        const auto batchable = [&drawCall](const DrawBatch &batch) {
+            return batch.material == drawCall.material
+                && batch.mesh->arena() == drawCall.mesh->arena()
+                && batch.mesh->primitive() == drawCall.mesh->primitive()
+                && batch.mesh->isIndexed() == drawCall.mesh->isIndexed();
+        };
+        if (m_drawBatches.empty() || !batchable(m_drawBatches.back()))
+            m_drawBatches.push_back({ drawCall.material, mesh, m_instanceBuffer, m_indirectBuffer, m_drawCommands.size() - 1, 0 });
+        ++m_drawBatches.back().commandCount;
+
+        it = runEnd;
+    }
+
+    if (!m_drawCommands.empty()) {
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_indirectBuffer);
+        m_indirectCapacity = std::max(m_indirectCapacity, m_drawCommands.size());
+        glBufferData(GL_DRAW_INDIRECT_BUFFER, m_indirectCapacity * sizeof(DrawCommand), nullptr, GL_STREAM_DRAW); // orphan the previous contents
+        glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, m_drawCommands.size() * sizeof(DrawCommand), m_drawCommands.data());
+    }
+
+    for (const auto *instances : m_culledInstances) {
+        for (std::size_t group = 0; group < instances->groupCount(); ++group)
+            m_drawBatches.push_back({ instances->groupMaterial(group), instances->mesh(), instances->instanceBuffer(), instances->commandBuffer(), group, 1 });
+    }
+    std::stable_sort(m_drawBatches.begin(), m_drawBatches.end(), [](const DrawBatch &lhs, const DrawBatch &rhs) {
+        return bucket(lhs.material) < bucket(rhs.material);
     });
+}
 
+template<typename Iterator>
+void Renderer::render(Iterator first, Iterator last)
+{
     std::optional<ShaderManager::Program> curProgram;
     const GX::GL::Texture *curTexture = nullptr;
+    const MeshArena *curArena = nullptr;
+    GLuint curInstanceBuffer = 0;
+    GLuint curIndirectBuffer = 0;
 
     for (auto it = first; it != last; ++it) {
-#if 0
-        if (!frustum.contains(drawCall.mesh->boundingBox(), drawCall.worldMatrix)) {
-            continue;
-        }
-#endif
-        const auto &drawCall = *it;
+        const auto &batch = *it;
 
-        const auto *material = drawCall.material;
+        const auto *material = batch.material;
         if (const auto program = material->program; curProgram == std::nullopt || *curProgram != program) {
             m_shaderManager->useProgram(program);
-            m_shaderManager->setUniform(ShaderManager::ProjectionMatrix, m_camera->projectionMatrix());
-            m_shaderManager->setUniform(ShaderManager::ViewMatrix, m_camera->viewMatrix());
             curProgram = program;
         }
         if (const auto *texture = material->texture; curTexture != texture) {
@@ -66,42 +244,97 @@ void Renderer::render(Iterator first, Iterator last) const
                 texture->bind();
             curTexture = texture;
         }
+        if (const auto *arena = batch.mesh->arena(); curArena != arena || curInstanceBuffer != batch.instanceBuffer) {
+            arena->bind(batch.instanceBuffer);
+            curArena = arena;
+            curInstanceBuffer = batch.instanceBuffer;
+        }
+        if (curIndirectBuffer != batch.indirectBuffer) {
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, batch.indirectBuffer);
+            curIndirectBuffer = batch.indirectBuffer;
+        }
 
-        m_shaderManager->setUniform(ShaderManager::ModelMatrix, drawCall.worldMatrix);
-        m_shaderManager->setUniform(ShaderManager::ModelViewMatrix, m_camera->viewMatrix() * drawCall.worldMatrix);
-        m_shaderManager->setUniform(ShaderManager::ModelViewProjection, m_camera->projectionMatrix() * m_camera->viewMatrix() * drawCall.worldMatrix);
-        const auto normalMatrix = glm::transpose(glm::inverse(glm::mat3(drawCall.worldMatrix)));
-        m_shaderManager->setUniform(ShaderManager::NormalMatrix, normalMatrix);
-        drawCall.mesh->render();
+        const auto *commands = reinterpret_cast<const GLvoid *>(batch.firstCommand * sizeof(DrawCommand));
+        if (batch.mesh->isIndexed())
+            glMultiDrawElementsIndirect(batch.mesh->primitive(), GL_UNSIGNED_INT, commands, batch.commandCount, sizeof(DrawCommand));
+        else
+            glMultiDrawArraysIndirect(batch.mesh->primitive(), commands, batch.commandCount, sizeof(DrawCommand));
     }
+
+    glBindVertexArray(0);
 }
 
 void Renderer::end()
 {
-    auto solidIt = std::stable_partition(m_drawCalls.begin(), m_drawCalls.end(), [](const DrawCall &drawCall) {
-        return drawCall.material->flags == Material::None;
+    if (m_drawCalls.empty() && m_culledInstances.empty())
+        return;
+
+    // frustum culling, all queued draw calls in one batch
+
+    const auto drawCallCount = m_drawCalls.size();
+    m_boundsCenters.resize(drawCallCount);
+    m_boundsHalfExtents.resize(drawCallCount);
+    m_visible.resize(drawCallCount);
+    for (std::size_t i = 0; i < drawCallCount; ++i) {
+        const auto &drawCall = m_drawCalls[i];
+        transformBoundingBox(drawCall.mesh->boundingBox(), drawCall.worldMatrix, m_boundsCenters[i], m_boundsHalfExtents[i]);
+    }
+    m_camera->frustum().testBoxes(m_boundsCenters.data(), m_boundsHalfExtents.data(), drawCallCount, m_visible.data());
+
+    m_sortItems.clear();
+    for (std::size_t i = 0; i < drawCallCount; ++i) {
+        if (m_visible[i])
+            m_sortItems.push_back({ m_drawCalls[i].sortKey, static_cast<std::uint32_t>(i) });
+    }
+    m_cullStats.tested += drawCallCount;
+    m_cullStats.culled += drawCallCount - m_sortItems.size();
+    radixSort(m_sortItems, m_sortScratch);
+
+    m_sortedDrawCalls.clear();
+    for (const auto &item : m_sortItems)
+        m_sortedDrawCalls.push_back(m_drawCalls[item.index]);
+    m_drawCalls.swap(m_sortedDrawCalls);
+
+    // upload the per-instance data and draw commands for the whole frame
+
+    m_instances.resize(m_drawCalls.size());
+    for (std::size_t i = 0; i < m_drawCalls.size(); ++i)
+        m_instances[i].modelMatrix = m_drawCalls[i].worldMatrix;
+    computeNormalMatrices(m_instances.data(), m_instances.size());
+    if (!m_instances.empty()) {
+        glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+        m_instanceCapacity = std::max(m_instanceCapacity, m_instances.size());
+        glBufferData(GL_ARRAY_BUFFER, m_instanceCapacity * sizeof(MeshInstance), nullptr, GL_STREAM_DRAW); // orphan the previous contents
+        glBufferSubData(GL_ARRAY_BUFFER, 0, m_instances.size() * sizeof(MeshInstance), m_instances.data());
+    }
+    buildBatches();
+
+    const auto solidIt = std::partition_point(m_drawBatches.begin(), m_drawBatches.end(), [](const DrawBatch &batch) {
+        return bucket(batch.material) == Bucket::Solid;
+    });
+    const auto transparentIt = std::partition_point(solidIt, m_drawBatches.end(), [](const DrawBatch &batch) {
+        return bucket(batch.material) == Bucket::Transparent;
     });
 
     // render solid meshes
 
     glDisable(GL_BLEND);
-    render(m_drawCalls.begin(), solidIt);
-
-    // render transparent meshes
+    render(m_drawBatches.begin(), solidIt);
 
-    auto transparentIt = std::stable_partition(solidIt, m_drawCalls.end(), [](const DrawCall &drawCall) {
-        return (drawCall.material->flags & Material::Transparent) != 0;
-    });
+    // render transparent meshes, in any order
 
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    glDepthMask(GL_FALSE); // disable writing to depth buffer
-    render(solidIt, transparentIt);
+    if (solidIt != transparentIt) {
+        m_transparencyPass->begin();
+        render(solidIt, transparentIt);
+        m_transparencyPass->end();
+    }
 
     // additive blend
 
+    glEnable(GL_BLEND);
     glBlendFunc(GL_ONE, GL_ONE);
-    render(transparentIt, m_drawCalls.end());
+    glDepthMask(GL_FALSE); // disable writing to depth buffer
+    render(transparentIt, m_drawBatches.end());
 
     glDepthMask(GL_TRUE);
 }
@@ -2,40 +2,81 @@
 
 #include <glm/glm.hpp>
 
+#include <cstdint>
 #include <memory>
 #include <vector>
 
 #include "camera.h"
+#include "mesh.h"
+#include "meshutils.h"
 
-class Mesh;
 struct Material;
 
+class InstanceCuller;
 class ShaderManager;
+class TransparencyPass;
 
-class Renderer
+class Renderer : private GX::NonCopyable
 {
 public:
-    Renderer(ShaderManager *shaderManager, const Camera *camera);
+    Renderer(ShaderManager *shaderManager, const Camera *camera, TransparencyPass *transparencyPass);
     ~Renderer();
 
     void resize(int width, int height);
 
     void begin();
     void render(const Mesh *mesh, const Material *material, const glm::mat4 &worldMatrix);
+    void render(const InstanceCuller *instances); // already culled, see InstanceCuller::cull
     void end();
 
+    struct CullStats {
+        std::size_t tested = 0;
+        std::size_t culled = 0;
+    };
+    const CullStats &cullStats() const { return m_cullStats; } // accumulated over end() calls
+    void resetCullStats() { m_cullStats = {}; }
+
 private:
+    using DrawCommand = Mesh::DrawCommand;
+    struct DrawBatch {
+        const Material *material;
+        const Mesh *mesh; // the first one, the others share its arena, primitive and indexing
+        GLuint instanceBuffer;
+        GLuint indirectBuffer;
+        std::size_t firstCommand;
+        std::size_t commandCount;
+    };
+    void buildBatches();
     template<typename Iterator>
-    void render(Iterator first, Iterator last) const;
+    void render(Iterator first, Iterator last);
 
     int m_width = 1;
     int m_height = 1;
     struct DrawCall {
+        std::uint64_t sortKey;
         const Mesh *mesh;
         const Material *material;
         glm::mat4 worldMatrix;
     };
     std::vector<DrawCall> m_drawCalls;
+    std::vector<DrawCall> m_sortedDrawCalls;
+    struct SortItem {
+        std::uint64_t key;
+        std::uint32_t index;
+    };
+    std::vector<SortItem> m_sortItems, m_sortScratch;
+    std::vector<glm::vec3> m_boundsCenters, m_boundsHalfExtents;
+    std::vector<std::uint8_t> m_visible;
+    CullStats m_cullStats;
+    std::vector<MeshInstance> m_instances; // parallel to m_drawCalls once sorted
+    GLuint m_instanceBuffer = 0;
+    std::size_t m_instanceCapacity = 0;
+    std::vector<DrawCommand> m_drawCommands; // one per run of draw calls sharing mesh and material
+    std::vector<DrawBatch> m_drawBatches; // one per multi-draw call
+    std::vector<const InstanceCuller *> m_culledInstances;
+    GLuint m_indirectBuffer = 0;
+    std::size_t m_indirectCapacity = 0;
     ShaderManager *m_shaderManager;
     const Camera *m_camera;
+    TransparencyPass *m_transparencyPass;
 };
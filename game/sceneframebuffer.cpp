@@ -0,0 +1,89 @@
+#include "sceneframebuffer.h"
+
+#include "shadermanager.h"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+
+SceneFramebuffer::SceneFramebuffer(ShaderManager *shaderManager)
+    : m_shaderManager(shaderManager)
+{
+    glGenVertexArrays(1, &m_emptyVertexArray);
+}
+
+SceneFramebuffer::~SceneFramebuffer()
+{
+    release();
+    glDeleteVertexArrays(1, &m_emptyVertexArray);
+}
+
+void SceneFramebuffer::release()
+{
+    glDeleteFramebuffers(1, &m_framebuffer);
+    glDeleteTextures(1, &m_colorTexture);
+    glDeleteRenderbuffers(1, &m_depthBuffer);
+    m_framebuffer = m_colorTexture = m_depthBuffer = 0;
+}
+
+void SceneFramebuffer::resize(int width, int height)
+{
+    if (width == m_width && height == m_height)
+        return;
+    m_width = width;
+    m_height = height;
+
+    release();
+
+    GLint windowSamples = 0, maxColorSamples = 1, maxSamples = 1;
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glGetIntegerv(GL_SAMPLES, &windowSamples);
+    glGetIntegerv(GL_MAX_COLOR_TEXTURE_SAMPLES, &maxColorSamples);
+    glGetIntegerv(GL_MAX_SAMPLES, &maxSamples);
+    m_samples = std::clamp(windowSamples, 1, std::min(maxColorSamples, maxSamples));
+
+    glGenTextures(1, &m_colorTexture);
+    glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, m_colorTexture);
+    glTexStorage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, m_samples, GL_RGBA8, width, height, GL_TRUE);
+    glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, 0);
+
+    glGenRenderbuffers(1, &m_depthBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, m_depthBuffer);
+    glRenderbufferStorageMultisample(GL_RENDERBUFFER, m_samples, DepthFormat, width, height);
+
+    glGenFramebuffers(1, &m_framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D_MULTISAMPLE, m_colorTexture, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_depthBuffer);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        spdlog::warn("Scene framebuffer incomplete");
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void SceneFramebuffer::bind()
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+    glClearColor(0, 0, 0, 0);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
+
+void SceneFramebuffer::resolve()
+{
+    // a draw rather than a blit, which would need the window's color format to match ours
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_BLEND);
+
+    m_shaderManager->useProgram(ShaderManager::SceneResolve);
+    m_shaderManager->setUniform(ShaderManager::SampleCount, m_samples);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, m_colorTexture);
+
+    glBindVertexArray(m_emptyVertexArray);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glBindVertexArray(0);
+
+    glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, 0);
+    glEnable(GL_DEPTH_TEST);
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <gx/noncopyable.h>
+
+#include <GL/glew.h>
+
+class ShaderManager;
+
+// Multisampled target the world is drawn into. The window's framebuffer has whatever formats the
+// platform picked, while TransparencyPass copies the depth buffer and needs a format it can match.
+// resolve() averages the samples into the window's framebuffer.
+class SceneFramebuffer : private GX::NonCopyable
+{
+public:
+    static constexpr GLenum DepthFormat = GL_DEPTH24_STENCIL8;
+
+    explicit SceneFramebuffer(ShaderManager *shaderManager);
+    ~SceneFramebuffer();
+
+    void resize(int width, int height); // with as many samples as the window's framebuffer
+
+    void bind(); // and clears it
+    void resolve(); // leaves the window's framebuffer bound
+
+    GLuint framebuffer() const { return m_framebuffer; }
+    int width() const { return m_width; }
+    int height() const { return m_height; }
+
+private:
+    void release();
+
+    ShaderManager *m_shaderManager;
+    int m_width = 0;
+    int m_height = 0;
+    int m_samples = 0;
+    GLuint m_framebuffer = 0;
+    GLuint m_colorTexture = 0;
+    GLuint m_depthBuffer = 0;
+    GLuint m_emptyVertexArray = 0;
+};
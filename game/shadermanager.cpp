@@ -2,6 +2,7 @@
 
 #include "loadprogram.h"
 
+#include <cstddef>
 #include <type_traits>
 
 #include <spdlog/spdlog.h>
@@ -20,6 +21,7 @@ loadProgram(ShaderManager::Program id)
         const char *vertexShader;
         const char *geometryShader;
         const char *fragmentShader;
+        const char *computeShader = nullptr; // instead of all the others
     };
     static const ProgramSource programSources[] = {
         { "debug.vert", nullptr, "debug.frag" }, // Debug
@@ -30,16 +32,75 @@ loadProgram(ShaderManager::Program id)
         { "adsfogclip.vert", nullptr, "adsfogclip.frag" }, // Lighting/Fog/Clip
         { "billboard.vert", "billboard.geom", "billboard.frag" }, // Billboard
         { "adsfog.vert", nullptr, "adsfogblend.frag" }, // Lighting/Fog/Blend
+        { "billboardquad.vert", nullptr, "billboard.frag" }, // Billboard/Instanced
+        { "decal.vert", nullptr, "decaloit.frag" }, // Decal/Transparent
+        { "ads.vert", nullptr, "adsoit.frag" }, // Lighting/Transparent
+        { "adsfog.vert", nullptr, "adsfogoit.frag" }, // Lighting/Fog/Transparent
+        { "fullscreen.vert", nullptr, "oitcomposite.frag" }, // TransparencyComposite
+        { "pathribbon.vert", nullptr, "adsfog.frag" }, // Ribbon/Lighting/Fog
+        { "pathribbon.vert", nullptr, "adsfogblend.frag" }, // Ribbon/Lighting/Fog/Blend
+        { "pathribbon.vert", nullptr, "adsfogoit.frag" }, // Ribbon/Lighting/Fog/Transparent
+        { nullptr, nullptr, nullptr, "cullinstances.comp" }, // CullInstances
+        { "fullscreen.vert", nullptr, "sceneresolve.frag" }, // SceneResolve
     };
     static_assert(std::extent_v<decltype(programSources)> == ShaderManager::NumPrograms, "expected number of programs to match");
 
     const auto &sources = programSources[id];
+    if (sources.computeShader)
+        return ::loadComputeProgram(sources.computeShader);
     return ::loadProgram(sources.vertexShader, sources.geometryShader, sources.fragmentShader);
 }
 
+// std140 layout of the FrameUniforms block in frameuniforms.glsl
+struct FrameUniformBlock {
+    glm::mat4 viewMatrix;
+    glm::mat4 projectionMatrix;
+    glm::vec3 eye;
+    float padding0;
+    glm::vec3 lightPosition;
+    float padding1;
+    glm::vec4 fogColor;
+    glm::vec2 fogDistance;
+    glm::vec2 padding2;
+    glm::vec4 clipPlane;
+};
+static_assert(offsetof(FrameUniformBlock, eye) == 128, "unexpected FrameUniforms layout");
+static_assert(offsetof(FrameUniformBlock, lightPosition) == 144, "unexpected FrameUniforms layout");
+static_assert(offsetof(FrameUniformBlock, fogDistance) == 176, "unexpected FrameUniforms layout");
+static_assert(offsetof(FrameUniformBlock, clipPlane) == 192, "unexpected FrameUniforms layout");
+
+constexpr GLuint FrameUniformsBinding = 0; // layout(binding=0) in frameuniforms.glsl
+
 } // namespace
 
-ShaderManager::~ShaderManager() = default;
+ShaderManager::ShaderManager()
+{
+    glGenBuffers(1, &m_frameUniformBuffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, m_frameUniformBuffer);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameUniformBlock), nullptr, GL_DYNAMIC_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, FrameUniformsBinding, m_frameUniformBuffer);
+}
+
+ShaderManager::~ShaderManager()
+{
+    glDeleteBuffers(1, &m_frameUniformBuffer);
+}
+
+void ShaderManager::setFrameUniforms(const FrameUniforms &uniforms)
+{
+    FrameUniformBlock block = {};
+    block.viewMatrix = uniforms.viewMatrix;
+    block.projectionMatrix = uniforms.projectionMatrix;
+    block.eye = uniforms.eye;
+    block.lightPosition = uniforms.lightPosition;
+    block.fogColor = uniforms.fogColor;
+    block.fogDistance = uniforms.fogDistance;
+    block.clipPlane = uniforms.clipPlane;
+
+    glBindBuffer(GL_UNIFORM_BUFFER, m_frameUniformBuffer);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(block), &block);
+    glBindBufferBase(GL_UNIFORM_BUFFER, FrameUniformsBinding, m_frameUniformBuffer);
+}
 
 void ShaderManager::useProgram(Program id)
 {
@@ -47,8 +108,29 @@ void ShaderManager::useProgram(Program id)
     if (!cachedProgram) {
         cachedProgram.reset(new CachedProgram);
         cachedProgram->program = loadProgram(id);
+
+        // resolve all uniform locations up front, -1 for the ones this program doesn't use
+        static constexpr const char *uniformNames[] = {
+            // clang-format off
+            "modelMatrix",
+            "normalMatrix",
+            "baseColorTexture",
+            "blendColor",
+            "baseInstance",
+            "pathFirst",
+            "pathSize",
+            "ribbonParts",
+            "boundsCenter",
+            "boundsHalfExtent",
+            "instanceEnd",
+            "sampleCount",
+            // clang-format on
+        };
+        static_assert(std::extent_v<decltype(uniformNames)> == NumUniforms, "expected number of uniforms to match");
+
         auto &uniforms = cachedProgram->uniformLocations;
-        std::fill(uniforms.begin(), uniforms.end(), -1);
+        for (int i = 0; i < NumUniforms; ++i)
+            uniforms[i] = cachedProgram->program ? cachedProgram->program->uniformLocation(uniformNames[i]) : -1;
     }
     if (cachedProgram.get() == m_currentProgram) {
         return;
@@ -59,34 +141,10 @@ void ShaderManager::useProgram(Program id)
     m_currentProgram = cachedProgram.get();
 }
 
-int ShaderManager::uniformLocation(Uniform id)
+int ShaderManager::uniformLocation(Uniform id) const
 {
-    if (!m_currentProgram || !m_currentProgram->program) {
+    if (!m_currentProgram) {
         return -1;
     }
-    auto location = m_currentProgram->uniformLocations[id];
-    if (location == -1) {
-        static constexpr const char *uniformNames[] = {
-            // clang-format off
-            "modelViewProjection",
-            "projectionMatrix",
-            "viewMatrix",
-            "modelMatrix",
-            "normalMatrix",
-            "modelViewMatrix",
-            "baseColorTexture",
-            "eye",
-            "fogColor",
-            "fogDistance",
-            "lightPosition",
-            "clipPlane",
-            "blendColor",
-            // clang-format on
-        };
-        static_assert(std::extent_v<decltype(uniformNames)> == NumUniforms, "expected number of uniforms to match");
-
-        location = m_currentProgram->program->uniformLocation(uniformNames[id]);
-        m_currentProgram->uniformLocations[id] = location;
-    }
-    return location;
+    return m_currentProgram->uniformLocations[id];
 }
@@ -9,9 +9,10 @@ namespace GX::GL {
 class ShaderProgram;
 };
 
-class ShaderManager
+class ShaderManager : private GX::NonCopyable
 {
 public:
+    ShaderManager();
     ~ShaderManager();
 
     enum Program {
@@ -23,27 +24,48 @@ public:
         LightingFogClip,
         Billboard,
         LightingFogBlend,
+        BillboardInstanced,
+        DecalTransparent,
+        LightingTransparent,
+        LightingFogTransparent,
+        TransparencyComposite,
+        RibbonLightingFog,
+        RibbonLightingFogBlend,
+        RibbonLightingFogTransparent,
+        CullInstances,
+        SceneResolve,
         NumPrograms
     };
     void useProgram(Program program);
 
     enum Uniform {
-        ModelViewProjection,
-        ProjectionMatrix,
-        ViewMatrix,
         ModelMatrix,
         NormalMatrix,
-        ModelViewMatrix,
         BaseColorTexture,
-        Eye,
-        FogColor,
-        FogDistance,
-        LightPosition,
-        ClipPlane,
         BlendColor,
+        BaseInstance,
+        PathFirst,
+        PathSize,
+        RibbonParts,
+        BoundsCenter,
+        BoundsHalfExtent,
+        InstanceEnd,
+        SampleCount,
         NumUniforms
     };
 
+    // per-frame state shared by all programs through the FrameUniforms block
+    struct FrameUniforms {
+        glm::mat4 viewMatrix;
+        glm::mat4 projectionMatrix;
+        glm::vec3 eye;
+        glm::vec3 lightPosition;
+        glm::vec4 fogColor;
+        glm::vec2 fogDistance; // near, far
+        glm::vec4 clipPlane;
+    };
+    void setFrameUniforms(const FrameUniforms &uniforms);
+
     template<typename T>
     void setUniform(Uniform uniform, T &&value)
     {
@@ -63,7 +85,7 @@ public:
     }
 
 private:
-    int uniformLocation(Uniform uniform);
+    int uniformLocation(Uniform uniform) const;
 
     struct CachedProgram {
         std::unique_ptr<GX::GL::ShaderProgram> program;
@@ -71,4 +93,5 @@ private:
     };
     std::array<std::unique_ptr<CachedProgram>, Program::NumPrograms> m_cachedPrograms;
     CachedProgram *m_currentProgram = nullptr;
+    GLuint m_frameUniformBuffer = 0;
 };
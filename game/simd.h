@@ -0,0 +1,6 @@
+#pragma once
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define HAVE_SSE
+#include <xmmintrin.h>
+#endif
@@ -0,0 +1,216 @@
+#include "bakedassets.h"
+
+#include <gx/packfile.h>
+#include <gx/pixmap.h>
+#include <gx/vfs.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Bakes a mesh, a texture and a track from the game's assets the way tools/baker does, then reads
+// them back: the baked files should hold the same data as the sources, and stop being used once
+// their source is edited, loose or packed. The assets are copied to a scratch directory first, so
+// the baked files don't end up next to the real ones.
+
+namespace {
+
+namespace fs = std::filesystem;
+
+double millisecondsSince(std::chrono::steady_clock::time_point start)
+{
+    const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+// makes the source newer than it was when it was baked, as if it had just been edited
+void touchSource(const std::string &path)
+{
+    fs::last_write_time(path, fs::file_time_type::clock::now() + std::chrono::seconds(1));
+}
+
+bool checkMesh(const std::string &path)
+{
+    auto start = std::chrono::steady_clock::now();
+    const auto model = loadObjModel(path);
+    const auto sourceMs = millisecondsSince(start);
+    if (!model || !writeBakedMesh(path, bakedPath(path), *model, GameVertexFormat)) {
+        std::cout << "Failed to bake " << path << '\n';
+        return false;
+    }
+
+    start = std::chrono::steady_clock::now();
+    const auto baked = readBakedMesh(path);
+    const auto bakedMs = millisecondsSince(start);
+    std::vector<PackedMeshVertex> vertices;
+    for (const auto &vertex : model->vertices)
+        vertices.push_back(packMeshVertex({ vertex.position, vertex.texcoord, vertex.normal }));
+    if (!baked || baked->vertexFormat != VertexFormat::Packed || baked->vertexCount != vertices.size() || baked->indexCount != model->indices.size()
+        || std::memcmp(baked->vertices, vertices.data(), vertices.size() * sizeof(PackedMeshVertex)) != 0
+        || std::memcmp(baked->indices, model->indices.data(), model->indices.size() * sizeof(unsigned)) != 0) {
+        std::cout << "Baked " << path << " differs from its source\n";
+        return false;
+    }
+
+    touchSource(path);
+    if (readBakedMesh(path)) {
+        std::cout << "Stale baked " << path << " was used\n";
+        return false;
+    }
+
+    std::cout << path << ": " << sourceMs << " ms from source, " << bakedMs << " ms baked\n";
+    return true;
+}
+
+bool checkTexture(const std::string &path)
+{
+    auto start = std::chrono::steady_clock::now();
+    const auto pixmap = GX::loadPixmap(path);
+    const auto sourceMs = millisecondsSince(start);
+    if (!pixmap || !writeBakedTexture(path, bakedPath(path), pixmap)) {
+        std::cout << "Failed to bake " << path << '\n';
+        return false;
+    }
+
+    start = std::chrono::steady_clock::now();
+    const auto baked = readBakedTexture(path);
+    const auto bakedMs = millisecondsSince(start);
+    if (!baked || baked.width != pixmap.width || baked.height != pixmap.height || baked.pixelType != pixmap.pixelType || baked.pixels != pixmap.pixels) {
+        std::cout << "Baked " << path << " differs from its source\n";
+        return false;
+    }
+
+    touchSource(path);
+    if (readBakedTexture(path)) {
+        std::cout << "Stale baked " << path << " was used\n";
+        return false;
+    }
+
+    std::cout << path << ": " << sourceMs << " ms from source, " << bakedMs << " ms baked\n";
+    return true;
+}
+
+bool checkTrack(const std::string &path)
+{
+    auto start = std::chrono::steady_clock::now();
+    const auto track = loadTrackJson(path);
+    const auto sourceMs = millisecondsSince(start);
+    if (!track || !writeBakedTrack(path, bakedPath(path), *track)) {
+        std::cout << "Failed to bake " << path << '\n';
+        return false;
+    }
+
+    start = std::chrono::steady_clock::now();
+    const auto baked = readBakedTrack(path);
+    const auto bakedMs = millisecondsSince(start);
+    const auto sameEvents = [](const Track &lhs, const Track &rhs) {
+        if (lhs.events.size() != rhs.events.size())
+            return false;
+        for (std::size_t i = 0; i < lhs.events.size(); ++i) {
+            const auto &a = lhs.events[i];
+            const auto &b = rhs.events[i];
+            if (a.type != b.type || a.track != b.track || a.start != b.start || a.duration != b.duration)
+                return false;
+        }
+        return true;
+    };
+    if (!baked || baked->audioFile != track->audioFile || baked->title != track->title || baked->author != track->author
+        || baked->beatsPerMinute != track->beatsPerMinute || baked->eventTracks != track->eventTracks || !sameEvents(*baked, *track)) {
+        std::cout << "Baked " << path << " differs from its source\n";
+        return false;
+    }
+
+    touchSource(path);
+    if (readBakedTrack(path)) {
+        std::cout << "Stale baked " << path << " was used\n";
+        return false;
+    }
+
+    std::cout << path << ": " << sourceMs << " ms from source, " << bakedMs << " ms baked\n";
+    return true;
+}
+
+// overwrites the 32 bit value at offset in the baked file for the source at path
+void corrupt(const std::string &path, std::size_t offset, std::uint32_t value)
+{
+    std::fstream file(bakedPath(path), std::ios::binary | std::ios::in | std::ios::out);
+    file.seekp(offset);
+    file.write(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+// a baked file with a wrong asset type or pixel type is ignored, rather than read as something else
+bool checkCorruptTexture(const std::string &path)
+{
+    constexpr std::size_t TypeOffset = 8; // in the header, after the magic and version
+    constexpr std::size_t PixelTypeOffset = 32; // after the header, the width and the height
+    const auto pixmap = GX::loadPixmap(path);
+    if (!pixmap || !writeBakedTexture(path, bakedPath(path), pixmap)) {
+        std::cout << "Failed to bake " << path << '\n';
+        return false;
+    }
+    corrupt(path, PixelTypeOffset, 0x7f);
+    if (readBakedTexture(path)) {
+        std::cout << "Baked " << path << " with an unknown pixel type was used\n";
+        return false;
+    }
+    corrupt(path, TypeOffset, 0x7f);
+    if (isBakedFileCurrent(path, bakedPath(path))) {
+        std::cout << "Baked " << path << " with an unknown asset type is current\n";
+        return false;
+    }
+    return true;
+}
+
+// bakes the mesh again into a pack mounted over the scratch directory the way the game mounts its
+// own: the packed baked file takes the place of the loose one until the source is edited, though
+// the pack keeps no file times
+bool checkPacked(const fs::path &scratch)
+{
+    const auto path = (scratch / "meshes/beat.obj").generic_string();
+    const auto bakedFile = (scratch / "baked/meshes/beat.obj.baked").generic_string();
+    const auto packPath = (scratch / "assets.pack").generic_string();
+    fs::create_directories(fs::path(bakedFile).parent_path());
+    const auto model = loadObjModel(path);
+    if (!model || !writeBakedMesh(path, bakedFile, *model, GameVertexFormat) || !GX::PackFile::write(packPath, { { "meshes/beat.obj.baked", bakedFile } })) {
+        std::cout << "Failed to pack " << bakedFile << '\n';
+        return false;
+    }
+
+    if (!GX::VFS::mount(packPath, scratch.generic_string()) || !GX::VFS::isPacked(bakedPath(path)) || !readBakedMesh(path)) {
+        std::cout << "Packed " << bakedFile << " wasn't used\n";
+        return false;
+    }
+
+    touchSource(path);
+    if (readBakedMesh(path)) {
+        std::cout << "Stale packed " << bakedFile << " was used\n";
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+int main()
+{
+    const auto scratch = fs::temp_directory_path() / "tst_bakedassets";
+    fs::remove_all(scratch);
+    for (const auto *asset : { "meshes/beat.obj", "textures/button0.png", "tracks/galaxies.json" }) {
+        const auto path = scratch / asset;
+        fs::create_directories(path.parent_path());
+        fs::copy_file(fs::path("assets") / asset, path);
+    }
+
+    const auto ok = checkMesh((scratch / "meshes/beat.obj").generic_string())
+        && checkTexture((scratch / "textures/button0.png").generic_string())
+        && checkTrack((scratch / "tracks/galaxies.json").generic_string())
+        && checkCorruptTexture((scratch / "textures/button0.png").generic_string())
+        && checkPacked(scratch);
+    fs::remove_all(scratch);
+    return ok ? 0 : 1;
+}
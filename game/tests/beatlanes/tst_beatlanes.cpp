@@ -0,0 +1,127 @@
+#include "beatlane.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+// Judges charts of increasing length the way World::updateBeats does, nobody pressing anything so
+// every beat ends up missed. Going through a lane's cursor should look at the same handful of beats
+// per frame whatever the length of the chart, where scanning all the beats grows with it.
+
+namespace {
+
+constexpr auto HitWindow = 0.2f; // same as in world.cpp
+constexpr auto BeatInterval = 0.125f; // seconds, a busy lane
+constexpr auto FrameTime = 1.0f / 60;
+constexpr auto Frames = 1000; // less than the shortest chart lasts from its middle
+constexpr auto ScanFrames = 100; // scanning a long chart is too slow to do for as many frames
+
+struct Chart {
+    explicit Chart(std::size_t size)
+        : start(size)
+        , alive(size, true)
+    {
+        for (std::size_t i = 0; i < size; ++i) {
+            start[i] = i * BeatInterval;
+            lane.beats.push_back(i);
+        }
+    }
+
+    // a beat that wasn't hit is done with once it's past the hit window
+    void judge(unsigned index, float time)
+    {
+        ++examined;
+        if (start[index] < time - HitWindow) {
+            alive[index] = false;
+            ++missed;
+        }
+    }
+
+    std::vector<float> start;
+    std::vector<bool> alive;
+    BeatLane lane;
+    std::size_t examined = 0;
+    std::size_t missed = 0;
+};
+
+struct Result {
+    double nsPerFrame;
+    std::size_t maxExamined;
+    std::size_t missed;
+};
+
+// the frames are taken from the middle of the chart, the cursor having caught up with them
+Result judgeWithCursor(std::size_t size, int frames)
+{
+    Chart chart(size);
+    const auto isFinished = [&chart](unsigned index) { return !chart.alive[index]; };
+    const auto startTime = [&chart](unsigned index) { return chart.start[index]; };
+    const auto firstFrame = 0.5f * size * BeatInterval;
+    for (std::size_t i = 0; chart.start[i] < firstFrame - HitWindow; ++i)
+        chart.alive[i] = false;
+    chart.lane.advance(isFinished, startTime, firstFrame);
+
+    std::size_t maxExamined = 0;
+    const auto begin = std::chrono::steady_clock::now();
+    for (int frame = 0; frame < frames; ++frame) {
+        const auto time = firstFrame + frame * FrameTime;
+        const auto examined = chart.examined;
+        const auto end = chart.lane.advance(isFinished, startTime, time + HitWindow);
+        for (auto i = chart.lane.head; i < end; ++i)
+            chart.judge(chart.lane.beats[i], time);
+        maxExamined = std::max(maxExamined, chart.examined - examined);
+    }
+    const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - begin;
+    return { elapsed.count() / frames, maxExamined, chart.missed };
+}
+
+// what updateBeats used to do: go through every beat that's still alive
+Result judgeWithScan(std::size_t size, int frames)
+{
+    Chart chart(size);
+    const auto firstFrame = 0.5f * size * BeatInterval;
+    for (std::size_t i = 0; chart.start[i] < firstFrame - HitWindow; ++i)
+        chart.alive[i] = false;
+
+    std::size_t maxExamined = 0;
+    const auto begin = std::chrono::steady_clock::now();
+    for (int frame = 0; frame < frames; ++frame) {
+        const auto time = firstFrame + frame * FrameTime;
+        const auto examined = chart.examined;
+        for (std::size_t i = 0; i < size; ++i) {
+            if (chart.alive[i] && chart.start[i] < time + HitWindow)
+                chart.judge(i, time);
+        }
+        maxExamined = std::max(maxExamined, chart.examined - examined);
+    }
+    const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - begin;
+    return { elapsed.count() / frames, maxExamined, chart.missed };
+}
+
+} // namespace
+
+int main()
+{
+    std::size_t firstMaxExamined = 0;
+    for (std::size_t size : { 1000, 10000, 100000, 1000000 }) {
+        const auto cursor = judgeWithCursor(size, Frames);
+        const auto scan = judgeWithScan(size, ScanFrames);
+
+        if (firstMaxExamined == 0)
+            firstMaxExamined = cursor.maxExamined;
+        if (cursor.maxExamined != firstMaxExamined) {
+            std::cout << "Looked at " << cursor.maxExamined << " beats in a frame with " << size
+                      << " beats, " << firstMaxExamined << " with fewer\n";
+            return 1;
+        }
+        const auto shortCursor = judgeWithCursor(size, ScanFrames);
+        if (shortCursor.missed != scan.missed || shortCursor.maxExamined != scan.maxExamined) {
+            std::cout << "Cursor and scan judged different beats with " << size << " beats\n";
+            return 1;
+        }
+
+        std::cout << size << " beats: cursor " << cursor.nsPerFrame << " ns/frame, scan " << scan.nsPerFrame
+                  << " ns/frame, at most " << cursor.maxExamined << " beats judged per frame\n";
+    }
+}
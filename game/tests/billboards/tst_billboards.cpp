@@ -0,0 +1,108 @@
+#include "particlesystem.h"
+#include "shadermanager.h"
+
+#include <gx/glwindow.h>
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <spdlog/spdlog.h>
+
+#include <chrono>
+#include <iostream>
+#include <random>
+
+// Draws the same particles as geometry shader billboards and as instanced quads and times both, for
+// increasing particle counts. Run it from a directory with the game's assets.
+
+namespace {
+
+constexpr auto Width = 1280;
+constexpr auto Height = 720;
+constexpr auto WarmUpFrames = 3;
+constexpr auto Frames = 20;
+
+class BenchmarkWindow : public GX::GLWindow
+{
+private:
+    void initializeGL() override { }
+    void paintGL() override { }
+    void update(double) override { }
+};
+
+void spawnParticles(ParticleSystem &particleSystem)
+{
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<float> unit(-1, 1);
+    while (particleSystem.particleCount() < particleSystem.maxParticles()) {
+        const auto position = glm::vec3(8 * unit(random), 4 * unit(random), -10 + 5 * unit(random));
+        const auto velocity = glm::vec3(unit(random), unit(random), unit(random));
+        particleSystem.spawnParticle(position, velocity, glm::vec2(0.05, 0.2), 1000);
+    }
+}
+
+struct Timing {
+    double gpuMs; // drawing, from a timer query
+    double frameMs; // writing the vertices and drawing, until glFinish returns
+};
+
+Timing timeBillboards(ParticleSystem &particleSystem)
+{
+    GLuint query;
+    glGenQueries(1, &query);
+    GLuint64 total = 0;
+    std::chrono::duration<double, std::milli> frameTotal {};
+    for (int frame = 0; frame < WarmUpFrames + Frames; ++frame) {
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        particleSystem.update(1.0f / 60);
+        glFinish();
+        const auto start = std::chrono::steady_clock::now();
+        glBeginQuery(GL_TIME_ELAPSED, query);
+        particleSystem.render(glm::mat4(1));
+        glEndQuery(GL_TIME_ELAPSED);
+        glFinish();
+        const auto end = std::chrono::steady_clock::now();
+        GLuint64 elapsed;
+        glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed);
+        if (frame >= WarmUpFrames) {
+            total += elapsed;
+            frameTotal += end - start;
+        }
+    }
+    glDeleteQueries(1, &query);
+    return { 1e-6 * total / Frames, frameTotal.count() / Frames };
+}
+
+} // namespace
+
+int main()
+{
+    BenchmarkWindow window;
+    if (!window.initialize(Width, Height, "billboards"))
+        return 1;
+
+    ShaderManager shaderManager;
+    ShaderManager::FrameUniforms frameUniforms;
+    frameUniforms.viewMatrix = glm::lookAt(glm::vec3(0, 0, 0), glm::vec3(0, 0, -1), glm::vec3(0, 1, 0));
+    frameUniforms.projectionMatrix = glm::perspective(glm::radians(45.0f), static_cast<float>(Width) / Height, 0.1f, 100.0f);
+    frameUniforms.eye = glm::vec3(0);
+    frameUniforms.lightPosition = glm::vec3(0, 10, 0);
+    frameUniforms.fogColor = glm::vec4(0);
+    frameUniforms.fogDistance = glm::vec2(100, 200);
+    frameUniforms.clipPlane = glm::vec4(0);
+    shaderManager.setFrameUniforms(frameUniforms);
+
+    glViewport(0, 0, Width, Height);
+    glEnable(GL_DEPTH_TEST);
+
+    for (std::size_t count : { 1000, 10000, 100000 }) {
+        ParticleSystem particleSystem(&shaderManager, count);
+        spawnParticles(particleSystem);
+
+        particleSystem.setBillboardMode(ParticleSystem::BillboardMode::GeometryShader);
+        const auto geometryShader = timeBillboards(particleSystem);
+        particleSystem.setBillboardMode(ParticleSystem::BillboardMode::InstancedQuads);
+        const auto instancedQuads = timeBillboards(particleSystem);
+
+        std::cout << count << " particles: geometry shader " << geometryShader.gpuMs << " ms GPU, " << geometryShader.frameMs
+                  << " ms frame; instanced quads " << instancedQuads.gpuMs << " ms GPU, " << instancedQuads.frameMs << " ms frame\n";
+    }
+}
@@ -0,0 +1,172 @@
+#include "objparser.h"
+
+#include <boost/algorithm/string.hpp>
+
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Checks what the OBJ parser makes of the corner cases, then times it on a big generated grid,
+// whose vertices are each shared by up to four quads, against the loader it replaced.
+
+namespace {
+
+constexpr auto GridSize = 500; // quads per side
+
+bool checkSharedVertices()
+{
+    const auto model = parseObj(
+        "# a quad and a triangle sharing an edge\r\n"
+        "v 0 0 0\r\n"
+        "v 1 0 0\r\n"
+        "v 1 1 0\r\n"
+        "v 0 1 0\r\n"
+        "v +2 -0.5 1e-1\r\n"
+        "vt 0 0\r\n"
+        "vn 0 0 1\r\n"
+        "f 1/1/1 2/1/1 3/1/1 4/1/1\r\n"
+        "f -4/-1/-1 5/1/1 -3/1/1\r\n"
+        "f 1//1 2//1 3//1\r\n");
+    if (!model || model->vertices.size() != 8 || model->indices.size() != 3 * 4)
+        return false;
+    // the last triangle has no texcoords, so its vertices are different ones
+    const std::vector<unsigned> indices = { 0, 1, 2, 0, 2, 3, 1, 4, 2, 5, 6, 7 };
+    if (model->indices != indices)
+        return false;
+    const auto &vertex = model->vertices[4];
+    return vertex.position == glm::vec3(2, -0.5f, 0.1f) && vertex.normal == glm::vec3(0, 0, 1);
+}
+
+bool checkMalformed()
+{
+    return !parseObj("v 0 0\n")
+        && !parseObj("v 0 0 0\nf 1 1\n")
+        && !parseObj("v 0 0 0\nf 1 2 3\n")
+        && !parseObj("v 0 0 0\nf 1/x 1 1\n");
+}
+
+std::string gridSource()
+{
+    std::string source;
+    for (int i = 0; i <= GridSize; ++i) {
+        for (int j = 0; j <= GridSize; ++j) {
+            source += "v " + std::to_string(0.01f * i) + ' ' + std::to_string(0.01f * j) + " 0\n";
+            source += "vt " + std::to_string(static_cast<float>(i) / GridSize) + ' ' + std::to_string(static_cast<float>(j) / GridSize) + '\n';
+        }
+    }
+    source += "vn 0 0 1\n";
+    for (int i = 0; i < GridSize; ++i) {
+        for (int j = 0; j < GridSize; ++j) {
+            const auto corner = [](int i, int j) {
+                const auto index = std::to_string(i * (GridSize + 1) + j + 1);
+                return ' ' + index + '/' + index + "/1";
+            };
+            source += 'f' + corner(i, j) + corner(i + 1, j) + corner(i + 1, j + 1) + corner(i, j + 1) + '\n';
+        }
+    }
+    return source;
+}
+
+// what loadMesh used to do: split each line into strings and make a vertex out of every corner
+std::vector<ObjModel::Vertex> parseObjWithGetline(const std::string &source)
+{
+    std::istringstream is(source);
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec2> texcoords;
+    std::vector<glm::vec3> normals;
+    struct Vertex {
+        int positionIndex;
+        int texcoordIndex;
+        int normalIndex;
+    };
+    using Face = std::vector<Vertex>;
+    std::vector<Face> faces;
+
+    std::string line;
+    while (std::getline(is, line)) {
+        std::vector<std::string> tokens;
+        boost::split(tokens, line, boost::is_any_of(" \t"), boost::token_compress_on);
+        if (tokens.empty())
+            continue;
+        if (tokens.front() == "v") {
+            positions.emplace_back(std::stof(tokens[1]), std::stof(tokens[2]), std::stof(tokens[3]));
+        } else if (tokens.front() == "vt") {
+            texcoords.emplace_back(std::stof(tokens[1]), std::stof(tokens[2]));
+        } else if (tokens.front() == "vn") {
+            normals.emplace_back(std::stof(tokens[1]), std::stof(tokens[2]), std::stof(tokens[3]));
+        } else if (tokens.front() == "f") {
+            Face f;
+            for (auto it = std::next(tokens.begin()); it != tokens.end(); ++it) {
+                std::vector<std::string> components;
+                boost::split(components, *it, boost::is_any_of("/"), boost::token_compress_off);
+                f.push_back({ std::stoi(components[0]) - 1, std::stoi(components[1]) - 1, std::stoi(components[2]) - 1 });
+            }
+            faces.push_back(f);
+        }
+    }
+
+    std::vector<ObjModel::Vertex> vertices;
+    for (const auto &face : faces) {
+        for (size_t i = 1; i < face.size() - 1; ++i) {
+            const auto toVertex = [&positions, &texcoords, &normals](const auto &vertex) {
+                return ObjModel::Vertex { positions[vertex.positionIndex], texcoords[vertex.texcoordIndex], normals[vertex.normalIndex] };
+            };
+            vertices.push_back(toVertex(face[0]));
+            vertices.push_back(toVertex(face[i]));
+            vertices.push_back(toVertex(face[i + 1]));
+        }
+    }
+    return vertices;
+}
+
+} // namespace
+
+int main()
+{
+    if (!checkSharedVertices()) {
+        std::cout << "Shared vertices weren't merged\n";
+        return 1;
+    }
+    if (!checkMalformed()) {
+        std::cout << "Malformed source was accepted\n";
+        return 1;
+    }
+
+    const auto source = gridSource();
+    const auto start = std::chrono::steady_clock::now();
+    const auto model = parseObj(source);
+    const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    if (!model) {
+        std::cout << "Failed to parse the grid\n";
+        return 1;
+    }
+    constexpr auto VertexCount = (GridSize + 1) * (GridSize + 1);
+    constexpr auto TriangleCount = 2 * GridSize * GridSize;
+    if (model->vertices.size() != VertexCount || model->indices.size() != 3 * TriangleCount) {
+        std::cout << "Grid has " << model->vertices.size() << " vertices and " << model->indices.size() / 3 << " triangles, expected "
+                  << VertexCount << " and " << TriangleCount << '\n';
+        return 1;
+    }
+
+    const auto oldStart = std::chrono::steady_clock::now();
+    const auto oldVertices = parseObjWithGetline(source);
+    const std::chrono::duration<double, std::milli> oldElapsed = std::chrono::steady_clock::now() - oldStart;
+    if (oldVertices.size() != model->indices.size()) {
+        std::cout << "Old loader made " << oldVertices.size() << " vertices, expected one per corner\n";
+        return 1;
+    }
+    for (std::size_t i = 0; i < oldVertices.size(); ++i) {
+        const auto &vertex = model->vertices[model->indices[i]];
+        if (vertex.position != oldVertices[i].position || vertex.texcoord != oldVertices[i].texcoord || vertex.normal != oldVertices[i].normal) {
+            std::cout << "Corner " << i << " differs from the old loader's\n";
+            return 1;
+        }
+    }
+
+    const auto megabytes = source.size() / (1024.0 * 1024.0);
+    std::cout << "Parsed " << megabytes << " MB in " << elapsed.count() << " ms (" << 1000 * megabytes / elapsed.count() << " MB/s), "
+              << model->vertices.size() << " vertices for " << 3 * TriangleCount << " corners; "
+              << "old loader " << oldElapsed.count() << " ms (" << 1000 * megabytes / oldElapsed.count() << " MB/s)\n";
+}
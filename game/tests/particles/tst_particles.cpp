@@ -0,0 +1,164 @@
+#include "particles.h"
+#include "tween.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// Runs full particle systems of increasing size for a while, respawning particles as they die, and
+// times a frame's update() and vertex writing. The previous layout, a vector of particle structs
+// erased from the middle and copied to a fresh vertex vector every frame, is timed next to it and
+// must end up with the same particles.
+
+namespace {
+
+constexpr auto FrameTime = 1.0f / 60;
+constexpr auto WarmUpFrames = 60;
+constexpr auto Frames = 120;
+constexpr auto MinLifetime = 1.0f;
+constexpr auto MaxLifetime = 2.0f;
+
+struct Spawn {
+    glm::vec3 position;
+    glm::vec3 velocity;
+    glm::vec2 size;
+    float lifetime;
+};
+
+// the same particles for both layouts
+class Spawner
+{
+public:
+    Spawn next()
+    {
+        std::uniform_real_distribution<float> unit(-1, 1);
+        std::uniform_real_distribution<float> lifetime(MinLifetime, MaxLifetime);
+        return { glm::vec3(unit(m_random), unit(m_random), unit(m_random)), glm::vec3(unit(m_random), unit(m_random), unit(m_random)),
+                 glm::vec2(1, 1), lifetime(m_random) };
+    }
+
+private:
+    std::mt19937 m_random { 1234 };
+};
+
+// the layout ParticleSystem had before Particles
+class ParticleVector
+{
+public:
+    explicit ParticleVector(std::size_t capacity)
+        : m_capacity(capacity)
+    {
+    }
+
+    void update(float elapsed)
+    {
+        auto it = m_particles.begin();
+        while (it != m_particles.end()) {
+            auto &particle = *it;
+            particle.time += elapsed;
+            if (particle.time >= particle.life) {
+                it = m_particles.erase(it);
+            } else {
+                particle.position += elapsed * particle.velocity;
+                ++it;
+            }
+        }
+    }
+
+    void spawn(const glm::vec3 &position, const glm::vec3 &velocity, const glm::vec2 &size, float lifetime)
+    {
+        if (m_particles.size() >= m_capacity)
+            return;
+        m_particles.push_back({ position, velocity, size, 0, lifetime });
+    }
+
+    std::vector<Particles::Vertex> vertices() const
+    {
+        std::vector<Particles::Vertex> result;
+        std::transform(m_particles.begin(), m_particles.end(), std::back_inserter(result), [](const Particle &particle) -> Particles::Vertex {
+            const float t = particle.time / particle.life;
+            float alpha = .25f * Tweeners::InOutQuadratic<float>()(t);
+            return { particle.position, particle.velocity, particle.size, alpha };
+        });
+        return result;
+    }
+
+    std::size_t size() const { return m_particles.size(); }
+    std::size_t capacity() const { return m_capacity; }
+
+private:
+    struct Particle {
+        glm::vec3 position;
+        glm::vec3 velocity;
+        glm::vec2 size;
+        float time;
+        float life;
+    };
+    std::size_t m_capacity;
+    std::vector<Particle> m_particles;
+};
+
+struct Result {
+    double msPerFrame;
+    std::size_t size;
+    double alphaSum; // to check the particles are the same
+};
+
+template<typename ParticleStore, typename WriteVertices>
+Result run(std::size_t capacity, ParticleStore &particles, WriteVertices writeVertices)
+{
+    Spawner spawner;
+    double alphaSum = 0;
+    std::chrono::duration<double, std::milli> elapsed {};
+    for (int frame = 0; frame < WarmUpFrames + Frames; ++frame) {
+        while (particles.size() < capacity) {
+            const auto spawn = spawner.next();
+            particles.spawn(spawn.position, spawn.velocity, spawn.size, spawn.lifetime);
+        }
+        const auto start = std::chrono::steady_clock::now();
+        particles.update(FrameTime);
+        alphaSum = writeVertices();
+        if (frame >= WarmUpFrames)
+            elapsed += std::chrono::steady_clock::now() - start;
+    }
+    return { elapsed.count() / Frames, particles.size(), alphaSum };
+}
+
+double sumAlpha(const Particles::Vertex *vertices, std::size_t count)
+{
+    double sum = 0;
+    for (std::size_t i = 0; i < count; ++i)
+        sum += vertices[i].alpha;
+    return sum;
+}
+
+} // namespace
+
+int main()
+{
+    for (std::size_t capacity : { 1000, 10000, 100000 }) {
+        Particles particles(capacity);
+        std::vector<Particles::Vertex> vertices(capacity); // stands for the mapped buffer
+        const auto soa = run(capacity, particles, [&] {
+            particles.writeVertices(vertices.data());
+            return sumAlpha(vertices.data(), particles.size());
+        });
+
+        ParticleVector particleVector(capacity);
+        const auto aos = run(capacity, particleVector, [&] {
+            const auto vertices = particleVector.vertices();
+            return sumAlpha(vertices.data(), vertices.size());
+        });
+
+        if (soa.size != aos.size || std::abs(soa.alphaSum - aos.alphaSum) > 1e-3 * capacity) {
+            std::cout << "Particles differ from the previous layout with " << capacity << " particles: " << soa.size << " vs "
+                      << aos.size << ", alpha " << soa.alphaSum << " vs " << aos.alphaSum << '\n';
+            return 1;
+        }
+
+        std::cout << capacity << " particles: " << soa.msPerFrame << " ms/frame, previous layout " << aos.msPerFrame << " ms/frame\n";
+    }
+}
@@ -0,0 +1,222 @@
+#include "pathgenerator.h"
+#include "pathtable.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+// Drives the path like World does for a very long song, without any GL: the path is generated
+// ahead of the camera a chunk at a time and discarded behind it, so the table should stop growing
+// after the first few chunks. Also times path lookups against what World did before PathTable, for
+// a song of usual length: placing every tap at level init, and the camera's state every frame.
+
+namespace {
+
+constexpr auto SongLength = 3 * 60 * 60.0f; // seconds
+constexpr auto FrameTime = 1.0f / 60;
+constexpr auto WarmUp = 60.0f; // seconds before the window should have found its size
+constexpr auto LevelLength = 4 * 60.0f; // seconds, for the lookup timings
+constexpr auto TapInterval = 0.25f;
+constexpr auto Repetitions = 20;
+
+// how World used to look the path up: a binary search over all the parts, then both orientations
+// converted to quaternions to interpolate them
+struct OldPath {
+    struct Part {
+        PathState state;
+        float distance;
+    };
+    std::vector<Part> parts;
+
+    PathState stateAt(float distance) const
+    {
+        const auto it = std::upper_bound(parts.begin(), parts.end(), distance, [](float distance, const auto &part) {
+            return distance < part.distance;
+        });
+        const std::size_t partIndex = it == parts.begin() ? 0 : std::distance(parts.begin(), it) - 1;
+        const auto &curPart = parts[partIndex];
+        const auto &nextPart = parts[partIndex + 1];
+        const float t = (distance - curPart.distance) / (nextPart.distance - curPart.distance);
+        const auto center = glm::mix(curPart.state.center, nextPart.state.center, t);
+        const auto q0 = glm::quat_cast(curPart.state.orientation);
+        const auto q1 = glm::quat_cast(nextPart.state.orientation);
+        return { glm::mat3_cast(glm::mix(q0, q1, t)), center };
+    }
+};
+
+bool sameState(const PathState &lhs, const PathState &rhs)
+{
+    for (int i = 0; i < 3; ++i) {
+        if (glm::distance(lhs.orientation[i], rhs.orientation[i]) > 1e-3f)
+            return false;
+    }
+    return glm::distance(lhs.center, rhs.center) < 1e-4f;
+}
+
+template<typename Lookups>
+double nsPerLookup(std::size_t count, Lookups lookups)
+{
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < Repetitions; ++i)
+        lookups();
+    const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / (Repetitions * count);
+}
+
+bool compareLookups()
+{
+    PathGenerator generator(1234);
+    PathTable path;
+    while (path.size() < 2 || path.endDistance() < PathGenerator::Speed * (LevelLength + PathGenerator::LookAhead))
+        generator.generateChunk(path);
+    OldPath oldPath;
+    for (auto i = path.firstIndex(); i < path.endIndex(); ++i)
+        oldPath.parts.push_back({ path.state(i), path.distance(i) });
+
+    std::vector<float> taps;
+    for (float time = 0; time < LevelLength; time += TapInterval)
+        taps.push_back(PathGenerator::Speed * time);
+    std::vector<PathState> oldStates(taps.size()), newStates(taps.size());
+    const auto oldInit = nsPerLookup(taps.size(), [&] {
+        for (std::size_t i = 0; i < taps.size(); ++i)
+            oldStates[i] = oldPath.stateAt(taps[i]);
+    });
+    const auto newInit = nsPerLookup(taps.size(), [&] {
+        PathTable::Cursor cursor(&path);
+        cursor.statesAt(taps.data(), taps.size(), newStates.data());
+    });
+    for (std::size_t i = 0; i < taps.size(); ++i) {
+        if (!sameState(oldStates[i], newStates[i])) {
+            std::cout << "Old and new lookups disagree at " << taps[i] << '\n';
+            return false;
+        }
+    }
+
+    std::vector<float> frames;
+    for (float time = 0; time < LevelLength; time += FrameTime)
+        frames.push_back(PathGenerator::Speed * time);
+    glm::vec3 oldSum(0), newSum(0); // so the lookups aren't optimized away
+    const auto oldCamera = nsPerLookup(frames.size(), [&] {
+        for (const auto distance : frames)
+            oldSum += oldPath.stateAt(distance).center;
+    });
+    const auto newCamera = nsPerLookup(frames.size(), [&] {
+        PathTable::Cursor cursor(&path);
+        for (const auto distance : frames)
+            newSum += cursor.stateAt(distance).center;
+    });
+    if (glm::distance(oldSum, newSum) > 1e-3f * glm::length(oldSum)) {
+        std::cout << "Old and new camera lookups disagree\n";
+        return false;
+    }
+
+    std::cout << path.size() << " parts, level init: " << oldInit << " ns per tap before, " << newInit << " ns with Cursor::statesAt; "
+              << "camera: " << oldCamera << " ns per frame before, " << newCamera << " ns with Cursor::stateAt\n";
+    return true;
+}
+
+bool checkSameSeedSamePath()
+{
+    PathTable path0, path1;
+    PathGenerator generator0(42), generator1(42);
+    for (int i = 0; i < 10; ++i) {
+        generator0.generateChunk(path0);
+        generator1.generateChunk(path1);
+    }
+    if (path0.size() != path1.size())
+        return false;
+    for (auto i = path0.firstIndex(); i < path0.endIndex(); ++i) {
+        if (path0.distance(i) != path1.distance(i) || path0.state(i).center != path1.state(i).center)
+            return false;
+    }
+    return true;
+}
+
+// growing must keep the parts of a table that has wrapped around
+bool checkGrowAfterWrap()
+{
+    PathTable path;
+    PathState state { glm::mat3(1), glm::vec3(0) };
+    int count = 0;
+    const auto append = [&](int n) {
+        for (int i = 0; i < n; ++i, ++count) {
+            state.center.x = count;
+            path.append(state, count);
+        }
+    };
+    append(1000);
+    path.discardBefore(700.5f);
+    append(2000);
+    for (auto i = path.firstIndex(); i < path.endIndex(); ++i) {
+        if (path.distance(i) != i || path.state(i).center.x != i)
+            return false;
+    }
+    return path.firstIndex() == 700 && path.stateAt(1234.25f).center.x == 1234.25f;
+}
+
+} // namespace
+
+int main()
+{
+    if (!checkSameSeedSamePath()) {
+        std::cout << "Same seed gave different paths\n";
+        return 1;
+    }
+    if (!checkGrowAfterWrap()) {
+        std::cout << "Path table lost parts when growing\n";
+        return 1;
+    }
+    if (!compareLookups())
+        return 1;
+
+    PathGenerator generator(1234);
+    PathTable path;
+    PathTable::Cursor cameraCursor(&path);
+
+    std::size_t maxSize = 0;
+    std::size_t warmCapacity = 0;
+    std::size_t lastChecked = 0;
+    double maxChunkMs = 0;
+
+    for (float time = 0; time < SongLength; time += FrameTime) {
+        const auto cameraDistance = PathGenerator::Speed * time;
+
+        while (path.size() < 2 || path.endDistance() < PathGenerator::Speed * (time + PathGenerator::LookAhead)) {
+            const auto start = std::chrono::steady_clock::now();
+            generator.generateChunk(path);
+            const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+            maxChunkMs = std::max(maxChunkMs, elapsed.count());
+        }
+        path.discardBefore(cameraDistance - PathGenerator::MarginBehind);
+
+        // new parts continue the path where it left off
+        for (auto i = std::max(lastChecked, path.firstIndex() + 1); i < path.endIndex(); ++i) {
+            const auto step = path.distance(i) - path.distance(i - 1);
+            const auto gap = glm::distance(path.state(i).center, path.state(i - 1).center);
+            if (step <= 0 || gap > step * 1.01f + 1e-3f) {
+                std::cout << "Discontinuous path at part " << i << " distance " << path.distance(i) << '\n';
+                return 1;
+            }
+        }
+        lastChecked = path.endIndex();
+
+        const auto camera = cameraCursor.stateAt(cameraDistance);
+        if (glm::distance(camera.center, path.stateAt(cameraDistance).center) > 1e-4f) {
+            std::cout << "Cursor and binary search disagree at " << cameraDistance << '\n';
+            return 1;
+        }
+
+        maxSize = std::max(maxSize, path.size());
+        if (time < WarmUp) {
+            warmCapacity = path.capacity();
+        } else if (path.capacity() != warmCapacity) {
+            std::cout << "Path table grew to " << path.capacity() << " parts after " << time << " seconds\n";
+            return 1;
+        }
+    }
+
+    std::cout << "Generated " << path.endIndex() << " parts over " << path.endDistance() << " units, "
+              << "at most " << maxSize << " kept (capacity " << path.capacity() << "), "
+              << "slowest chunk " << maxChunkMs << " ms\n";
+}
@@ -0,0 +1,91 @@
+#include "vertexcache.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <iostream>
+#include <random>
+
+// Reorders a grid whose triangles were shuffled, which should bring the cache miss ratio from close
+// to the worst case down near the best one, while drawing the same triangles.
+
+namespace {
+
+constexpr auto GridSize = 300; // quads per side
+constexpr auto CacheSize = 16;
+constexpr auto MaxOptimizedRatio = 0.8f;
+
+using Triangle = std::array<unsigned, 3>;
+
+// rotated so the smallest index comes first, which keeps the winding
+std::vector<Triangle> triangles(const std::vector<unsigned> &indices, const std::vector<unsigned> &vertexIds)
+{
+    std::vector<Triangle> result;
+    for (std::size_t i = 0; i < indices.size(); i += 3) {
+        Triangle triangle = { vertexIds[indices[i]], vertexIds[indices[i + 1]], vertexIds[indices[i + 2]] };
+        std::rotate(triangle.begin(), std::min_element(triangle.begin(), triangle.end()), triangle.end());
+        result.push_back(triangle);
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+} // namespace
+
+int main()
+{
+    std::vector<Triangle> grid;
+    for (unsigned i = 0; i < GridSize; ++i) {
+        for (unsigned j = 0; j < GridSize; ++j) {
+            const auto v00 = i * (GridSize + 1) + j;
+            const auto v10 = v00 + GridSize + 1;
+            grid.push_back({ v00, v10, v10 + 1 });
+            grid.push_back({ v00, v10 + 1, v00 + 1 });
+        }
+    }
+    std::shuffle(grid.begin(), grid.end(), std::mt19937(1234));
+
+    std::vector<unsigned> indices;
+    for (const auto &triangle : grid)
+        indices.insert(indices.end(), triangle.begin(), triangle.end());
+    constexpr auto VertexCount = (GridSize + 1) * (GridSize + 1);
+    std::vector<unsigned> vertexIds(VertexCount); // the vertex data, to follow it around
+    for (unsigned i = 0; i < VertexCount; ++i)
+        vertexIds[i] = i;
+
+    const auto originalTriangles = triangles(indices, vertexIds);
+    const auto originalRatio = averageCacheMissRatio(indices, VertexCount, CacheSize);
+
+    const auto start = std::chrono::steady_clock::now();
+    optimizeVertexCache(indices, VertexCount);
+    const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    const auto optimizedRatio = averageCacheMissRatio(indices, VertexCount, CacheSize);
+
+    optimizeVertexFetch(vertexIds, indices);
+    if (averageCacheMissRatio(indices, VertexCount, CacheSize) != optimizedRatio) {
+        std::cout << "Reordering the vertices changed the cache miss ratio\n";
+        return 1;
+    }
+
+    if (triangles(indices, vertexIds) != originalTriangles) {
+        std::cout << "The reordered mesh has different triangles\n";
+        return 1;
+    }
+
+    // vertices are stored in the order they're first used
+    unsigned nextVertex = 0;
+    for (const auto index : indices) {
+        if (index > nextVertex) {
+            std::cout << "Vertex " << index << " is used before vertex " << nextVertex << '\n';
+            return 1;
+        }
+        if (index == nextVertex)
+            ++nextVertex;
+    }
+
+    std::cout << "ACMR " << originalRatio << " -> " << optimizedRatio << " for " << grid.size() << " triangles, in " << elapsed.count() << " ms\n";
+    if (optimizedRatio > MaxOptimizedRatio) {
+        std::cout << "Cache miss ratio is above " << MaxOptimizedRatio << '\n';
+        return 1;
+    }
+}
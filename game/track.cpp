@@ -1,20 +1,29 @@
 #include "track.h"
 
-#include <gx/ioutil.h>
+#include "bakedassets.h"
+
+#include <gx/vfs.h>
 
 #include <rapidjson/document.h>
 #include <spdlog/spdlog.h>
 
 std::unique_ptr<Track> loadTrack(const std::string &jsonPath)
 {
-    const auto json = GX::Util::readFile(jsonPath);
+    if (auto track = readBakedTrack(jsonPath))
+        return track;
+    return loadTrackJson(jsonPath);
+}
+
+std::unique_ptr<Track> loadTrackJson(const std::string &jsonPath)
+{
+    const GX::VFS::File json(jsonPath);
     if (!json) {
         spdlog::warn("Could not read track file {}", jsonPath);
         return {};
     }
 
     rapidjson::Document document;
-    document.Parse(reinterpret_cast<const char *>(json->data()));
+    document.Parse(json.text().data(), json.size());
     if (document.HasParseError()) {
         spdlog::warn("Failed to parse track file {}", jsonPath);
         return {};
@@ -24,4 +24,6 @@ struct Track {
     std::vector<Event> events;
 };
 
+// the baked track if it's current, see bakedassets.h, or else loadTrackJson
 std::unique_ptr<Track> loadTrack(const std::string &jsonPath);
+std::unique_ptr<Track> loadTrackJson(const std::string &jsonPath);
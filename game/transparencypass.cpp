@@ -0,0 +1,130 @@
+#include "transparencypass.h"
+
+#include "sceneframebuffer.h"
+#include "shadermanager.h"
+
+#include <spdlog/spdlog.h>
+
+namespace {
+
+GLuint makeTarget(GLenum internalFormat, int width, int height)
+{
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexStorage2D(GL_TEXTURE_2D, 1, internalFormat, width, height);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    return texture;
+}
+
+} // namespace
+
+TransparencyPass::TransparencyPass(ShaderManager *shaderManager, const SceneFramebuffer *scene)
+    : m_shaderManager(shaderManager)
+    , m_scene(scene)
+{
+    glGenVertexArrays(1, &m_emptyVertexArray);
+}
+
+TransparencyPass::~TransparencyPass()
+{
+    release();
+    glDeleteVertexArrays(1, &m_emptyVertexArray);
+}
+
+void TransparencyPass::release()
+{
+    glDeleteFramebuffers(1, &m_framebuffer);
+    glDeleteTextures(1, &m_accumulationTexture);
+    glDeleteTextures(1, &m_revealageTexture);
+    glDeleteRenderbuffers(1, &m_depthBuffer);
+    m_framebuffer = m_accumulationTexture = m_revealageTexture = m_depthBuffer = 0;
+}
+
+void TransparencyPass::resize(int width, int height)
+{
+    if (width == m_width && height == m_height)
+        return;
+    m_width = width;
+    m_height = height;
+
+    release();
+
+    m_accumulationTexture = makeTarget(GL_RGBA16F, width, height);
+    m_revealageTexture = makeTarget(GL_R8, width, height);
+
+    // same format as the scene's, for the blit in begin()
+    glGenRenderbuffers(1, &m_depthBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, m_depthBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, SceneFramebuffer::DepthFormat, width, height);
+
+    glGenFramebuffers(1, &m_framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_accumulationTexture, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, m_revealageTexture, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_depthBuffer);
+    static const GLenum drawBuffers[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+    glDrawBuffers(2, drawBuffers);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        spdlog::warn("Transparency framebuffer incomplete");
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void TransparencyPass::clear()
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+    static const GLfloat accumulation[] = { 0, 0, 0, 0 };
+    static const GLfloat revealage[] = { 1, 1, 1, 1 };
+    glClearBufferfv(GL_COLOR, 0, accumulation);
+    glClearBufferfv(GL_COLOR, 1, revealage);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_scene->framebuffer());
+    m_empty = true;
+}
+
+void TransparencyPass::begin()
+{
+    // transparent fragments must still be hidden by the opaque ones; the scene is multisampled, this
+    // takes one sample per pixel
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, m_scene->framebuffer());
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_framebuffer);
+    glBlitFramebuffer(0, 0, m_width, m_height, 0, 0, m_width, m_height, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+
+    glEnable(GL_BLEND);
+    glBlendFunci(0, GL_ONE, GL_ONE);
+    glBlendFunci(1, GL_ZERO, GL_ONE_MINUS_SRC_COLOR);
+    glDepthMask(GL_FALSE); // disable writing to depth buffer
+
+    m_empty = false;
+}
+
+void TransparencyPass::end()
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, m_scene->framebuffer());
+    glDepthMask(GL_TRUE);
+}
+
+void TransparencyPass::composite()
+{
+    if (m_empty)
+        return;
+
+    glDisable(GL_DEPTH_TEST);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_ONE_MINUS_SRC_ALPHA, GL_SRC_ALPHA);
+
+    m_shaderManager->useProgram(ShaderManager::TransparencyComposite);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, m_revealageTexture);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, m_accumulationTexture);
+
+    glBindVertexArray(m_emptyVertexArray);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glBindVertexArray(0);
+
+    glEnable(GL_DEPTH_TEST);
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <gx/noncopyable.h>
+
+#include <GL/glew.h>
+
+class ShaderManager;
+class SceneFramebuffer;
+
+// Weighted blended order-independent transparency. Transparent geometry is drawn between begin() and
+// end() in any order, with one of the *Transparent programs, into an accumulation and a revealage
+// target; composite() then blends the result over the scene.
+class TransparencyPass : private GX::NonCopyable
+{
+public:
+    TransparencyPass(ShaderManager *shaderManager, const SceneFramebuffer *scene);
+    ~TransparencyPass();
+
+    void resize(int width, int height);
+
+    void clear(); // once per frame, before anything is drawn into the pass
+    void begin(); // picks up the depth buffer of the opaque geometry drawn into the scene so far
+    void end(); // leaves the scene bound
+    void composite();
+
+private:
+    void release();
+
+    ShaderManager *m_shaderManager;
+    const SceneFramebuffer *m_scene;
+    int m_width = 0;
+    int m_height = 0;
+    GLuint m_framebuffer = 0;
+    GLuint m_accumulationTexture = 0;
+    GLuint m_revealageTexture = 0;
+    GLuint m_depthBuffer = 0;
+    GLuint m_emptyVertexArray = 0;
+    bool m_empty = true; // nothing drawn since clear()
+};
@@ -0,0 +1,168 @@
+#include "vertexcache.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+
+namespace {
+
+// the scores assume an LRU cache of this size, which works well for the actual (smaller) FIFO ones
+constexpr auto CacheSize = 32;
+constexpr auto CacheDecayPower = 1.5f;
+constexpr auto LastTriangleScore = 0.75f;
+constexpr auto ValenceBoostScale = 2.0f;
+constexpr auto ValenceBoostPower = 0.5f;
+
+// higher for vertices recently used, and for vertices with few triangles left to draw so they
+// don't get left behind
+float vertexScore(int cachePosition, unsigned liveTriangles)
+{
+    if (liveTriangles == 0)
+        return -1.0f;
+    float score = 0.0f;
+    if (cachePosition >= 0) {
+        if (cachePosition < 3) {
+            // used by the last triangle, its vertices count the same whichever order they went in
+            score = LastTriangleScore;
+        } else {
+            const auto scale = 1.0f / (CacheSize - 3);
+            score = std::pow(1.0f - (cachePosition - 3) * scale, CacheDecayPower);
+        }
+    }
+    score += ValenceBoostScale * std::pow(static_cast<float>(liveTriangles), -ValenceBoostPower);
+    return score;
+}
+
+} // namespace
+
+float averageCacheMissRatio(const std::vector<unsigned> &indices, std::size_t vertexCount, std::size_t cacheSize)
+{
+    const auto triangleCount = indices.size() / 3;
+    if (triangleCount == 0)
+        return 0.0f;
+
+    // a vertex is cached if fewer than cacheSize misses happened since its own
+    std::vector<std::size_t> missedAt(vertexCount, 0);
+    std::size_t misses = 0;
+    for (const auto index : indices) {
+        if (missedAt[index] != 0 && misses - missedAt[index] < cacheSize)
+            continue;
+        missedAt[index] = ++misses;
+    }
+    return static_cast<float>(misses) / triangleCount;
+}
+
+void optimizeVertexCache(std::vector<unsigned> &indices, std::size_t vertexCount)
+{
+    const auto triangleCount = indices.size() / 3;
+    if (triangleCount == 0)
+        return;
+
+    // the triangles using each vertex, in one array: the ones still to be drawn are the first
+    // liveTriangles[v] from vertexTriangles[firstTriangle[v]]
+    std::vector<unsigned> firstTriangle(vertexCount + 1, 0);
+    for (const auto index : indices)
+        ++firstTriangle[index + 1];
+    std::partial_sum(firstTriangle.begin(), firstTriangle.end(), firstTriangle.begin());
+    std::vector<unsigned> vertexTriangles(3 * triangleCount);
+    std::vector<unsigned> liveTriangles(vertexCount, 0);
+    for (std::size_t triangle = 0; triangle < triangleCount; ++triangle) {
+        for (int i = 0; i < 3; ++i) {
+            const auto vertex = indices[3 * triangle + i];
+            vertexTriangles[firstTriangle[vertex] + liveTriangles[vertex]++] = triangle;
+        }
+    }
+
+    std::vector<int> cachePositions(vertexCount, -1);
+    std::vector<float> vertexScores(vertexCount);
+    for (std::size_t vertex = 0; vertex < vertexCount; ++vertex)
+        vertexScores[vertex] = vertexScore(-1, liveTriangles[vertex]);
+    std::vector<float> triangleScores(triangleCount);
+    for (std::size_t triangle = 0; triangle < triangleCount; ++triangle) {
+        const auto *vertices = &indices[3 * triangle];
+        triangleScores[triangle] = vertexScores[vertices[0]] + vertexScores[vertices[1]] + vertexScores[vertices[2]];
+    }
+    std::vector<std::uint8_t> drawn(triangleCount, 0);
+
+    std::vector<unsigned> cache, nextCache; // most recently used first
+    std::vector<unsigned> result;
+    result.reserve(indices.size());
+
+    auto best = std::distance(triangleScores.begin(), std::max_element(triangleScores.begin(), triangleScores.end()));
+    std::size_t nextUndrawn = 0; // to start over from when the cache has nothing left to offer
+
+    while (result.size() < 3 * triangleCount) {
+        if (best < 0) {
+            while (drawn[nextUndrawn])
+                ++nextUndrawn;
+            best = nextUndrawn;
+        }
+
+        drawn[best] = 1;
+        const auto *vertices = &indices[3 * best];
+        result.insert(result.end(), vertices, vertices + 3);
+
+        // the triangle goes to the front of the cache, and out of its vertices' live triangles
+        nextCache.clear();
+        for (int i = 0; i < 3; ++i) {
+            const auto vertex = vertices[i];
+            auto *first = &vertexTriangles[firstTriangle[vertex]];
+            auto *last = first + liveTriangles[vertex];
+            std::iter_swap(std::find(first, last, best), last - 1);
+            --liveTriangles[vertex];
+            if (std::find(nextCache.begin(), nextCache.end(), vertex) == nextCache.end())
+                nextCache.push_back(vertex);
+        }
+        for (const auto vertex : cache) {
+            if (std::find(vertices, vertices + 3, vertex) == vertices + 3)
+                nextCache.push_back(vertex);
+        }
+
+        // rescore the vertices that moved in the cache (or fell out of it), and their triangles
+        for (std::size_t i = 0; i < nextCache.size(); ++i) {
+            const auto vertex = nextCache[i];
+            cachePositions[vertex] = i < CacheSize ? i : -1;
+            const auto score = vertexScore(cachePositions[vertex], liveTriangles[vertex]);
+            const auto delta = score - vertexScores[vertex];
+            vertexScores[vertex] = score;
+            const auto *first = &vertexTriangles[firstTriangle[vertex]];
+            for (const auto *triangle = first; triangle != first + liveTriangles[vertex]; ++triangle)
+                triangleScores[*triangle] += delta;
+        }
+        nextCache.resize(std::min<std::size_t>(nextCache.size(), CacheSize));
+        cache.swap(nextCache);
+
+        // the next triangle is the best one using a cached vertex
+        best = -1;
+        auto bestScore = std::numeric_limits<float>::lowest();
+        for (const auto vertex : cache) {
+            const auto *first = &vertexTriangles[firstTriangle[vertex]];
+            for (const auto *triangle = first; triangle != first + liveTriangles[vertex]; ++triangle) {
+                if (triangleScores[*triangle] > bestScore) {
+                    best = *triangle;
+                    bestScore = triangleScores[*triangle];
+                }
+            }
+        }
+    }
+
+    indices.swap(result);
+}
+
+std::vector<unsigned> optimizeVertexFetch(std::vector<unsigned> &indices, std::size_t vertexCount)
+{
+    constexpr auto Unused = std::numeric_limits<unsigned>::max();
+    std::vector<unsigned> newIndices(vertexCount, Unused);
+    std::vector<unsigned> order;
+    order.reserve(vertexCount);
+    for (auto &index : indices) {
+        if (newIndices[index] == Unused) {
+            newIndices[index] = order.size();
+            order.push_back(index);
+        }
+        index = newIndices[index];
+    }
+    return order;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// Reordering of indexed triangle lists for the GPU's post-transform vertex cache and vertex fetch.
+
+// Average cache miss ratio, vertex shader runs per triangle with a FIFO cache of cacheSize entries:
+// 3 when nothing is reused, 0.5 at best for big regular meshes.
+float averageCacheMissRatio(const std::vector<unsigned> &indices, std::size_t vertexCount, std::size_t cacheSize = 16);
+
+// Reorders the triangles so that the ones sharing vertices are drawn close together, with Tom
+// Forsyth's linear-speed vertex cache optimisation.
+void optimizeVertexCache(std::vector<unsigned> &indices, std::size_t vertexCount);
+
+// Renumbers the vertices in the order the triangles first use them and returns the new order, as the
+// old index of each vertex; unused vertices are left out.
+std::vector<unsigned> optimizeVertexFetch(std::vector<unsigned> &indices, std::size_t vertexCount);
+
+template<typename Vertex>
+void optimizeVertexFetch(std::vector<Vertex> &vertices, std::vector<unsigned> &indices)
+{
+    const auto order = optimizeVertexFetch(indices, vertices.size());
+    std::vector<Vertex> reordered;
+    reordered.reserve(order.size());
+    for (const auto index : order)
+        reordered.push_back(vertices[index]);
+    vertices.swap(reordered);
+}
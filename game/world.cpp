@@ -1,36 +1,43 @@
 #include "world.h"
 
-#include "bezier.h"
 #include "camera.h"
+#include "debrissystem.h"
 #include "hudpainter.h"
+#include "instanceculler.h"
 #include "material.h"
 #include "mesh.h"
 #include "meshutils.h"
 #include "oggplayer.h"
 #include "particlesystem.h"
+#include "pathribbons.h"
 #include "renderer.h"
+#include "sceneframebuffer.h"
 #include "shadermanager.h"
 #include "track.h"
+#include "transparencypass.h"
 #include "tween.h"
 
+#include <gx/texture.h>
+
 #include <fmt/format.h>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/random.hpp>
-#include <glm/gtx/matrix_decompose.hpp>
 #include <glm/gtx/string_cast.hpp>
 #include <spdlog/spdlog.h>
 
 #include <algorithm>
-#include <optional>
+#include <array>
+#include <cmath>
+#include <functional>
 
 using namespace std::string_literals;
 
 namespace {
 
-const Material *trackMaterial()
+const GX::GL::Texture *trackTexture()
 {
-    static const Material material { ShaderManager::Program::LightingFog, Material::Transparent, cachedTexture("track.png"s) };
-    return &material;
+    static const GX::GL::Texture *texture = cachedTexture("track.png"s);
+    return texture;
 }
 
 const Material *beatMaterial(int index)
@@ -45,37 +52,13 @@ const Material *beatMaterial(int index)
     return &materials[index];
 }
 
-const Material *longNoteMaterial(int index)
-{
-    static const std::vector<Material> materials = {
-        { ShaderManager::Program::LightingFogBlend, Material::None, cachedTexture("beat0.png"s) },
-        { ShaderManager::Program::LightingFogBlend, Material::None, cachedTexture("beat1.png"s) },
-        { ShaderManager::Program::LightingFogBlend, Material::None, cachedTexture("beat2.png"s) },
-        { ShaderManager::Program::LightingFogBlend, Material::None, cachedTexture("beat3.png"s) },
-    };
-    assert(index >= 0 && index < materials.size());
-    return &materials[index];
-}
-
-const Material *debrisMaterial(int index)
-{
-    static const std::vector<Material> materials = {
-        { ShaderManager::Program::Lighting, Material::Transparent, cachedTexture("debris0.png"s) },
-        { ShaderManager::Program::Lighting, Material::Transparent, cachedTexture("debris1.png"s) },
-        { ShaderManager::Program::Lighting, Material::Transparent, cachedTexture("debris2.png"s) },
-        { ShaderManager::Program::Lighting, Material::Transparent, cachedTexture("debris3.png"s) },
-    };
-    assert(index >= 0 && index < materials.size());
-    return &materials[index];
-}
-
 const Material *buttonMaterial(int index)
 {
     static const std::vector<Material> materials = {
-        { ShaderManager::Program::Decal, Material::Transparent, cachedTexture("button0.png"s) },
-        { ShaderManager::Program::Decal, Material::Transparent, cachedTexture("button1.png"s) },
-        { ShaderManager::Program::Decal, Material::Transparent, cachedTexture("button2.png"s) },
-        { ShaderManager::Program::Decal, Material::Transparent, cachedTexture("button3.png"s) },
+        { ShaderManager::Program::DecalTransparent, Material::Transparent, cachedTexture("button0.png"s) },
+        { ShaderManager::Program::DecalTransparent, Material::Transparent, cachedTexture("button1.png"s) },
+        { ShaderManager::Program::DecalTransparent, Material::Transparent, cachedTexture("button2.png"s) },
+        { ShaderManager::Program::DecalTransparent, Material::Transparent, cachedTexture("button3.png"s) },
     };
     assert(index >= 0 && index < materials.size());
     return &materials[index];
@@ -83,7 +66,7 @@ const Material *buttonMaterial(int index)
 
 const Material *buttonMaterial()
 {
-    static const Material material { ShaderManager::Program::Lighting, Material::Transparent, cachedTexture("button0.png"s) };
+    static const Material material { ShaderManager::Program::LightingTransparent, Material::Transparent, cachedTexture("button0.png"s) };
     return &material;
 }
 
@@ -108,9 +91,11 @@ std::string meshPath(const std::string &basename)
     return std::string("assets/meshes/") + basename;
 }
 
-constexpr auto Speed = 0.5f;
 constexpr auto TrackWidth = 0.25f;
 constexpr auto HitWindow = 0.2f;
+constexpr auto CullStatsInterval = 1.0f; // seconds
+constexpr auto FogNear = 0.1f;
+constexpr auto FogFar = 5.0f;
 
 } // namespace
 
@@ -377,15 +362,23 @@ private:
 World::World(ShaderManager *shaderManager)
     : m_shaderManager(shaderManager)
     , m_camera(new Camera)
-    , m_renderer(new Renderer(m_shaderManager, m_camera.get()))
-    , m_particleSystem(new ParticleSystem(m_shaderManager, m_camera.get()))
+    , m_sceneFramebuffer(new SceneFramebuffer(m_shaderManager))
+    , m_transparencyPass(new TransparencyPass(m_shaderManager, m_sceneFramebuffer.get()))
+    , m_renderer(new Renderer(m_shaderManager, m_camera.get(), m_transparencyPass.get()))
+    , m_particleSystem(new ParticleSystem(m_shaderManager))
+    , m_pathRibbons(new PathRibbons(m_shaderManager))
+    , m_meshArena(makeMeshArena(GameVertexFormat))
     , m_comboCounter(new ComboCounter)
     , m_player(new OggPlayer)
 {
     initializeBeatMeshes();
     initializeMarkerMesh();
     initializeButtonMesh();
-    initializeTrackMesh();
+    const auto vertexCount = m_meshArena->allocatedVertices();
+    spdlog::info("Mesh vertices: {} bytes ({} as MeshVertex)", vertexCount * m_meshArena->vertexSize(), vertexCount * sizeof(MeshVertex));
+    m_tapCuller = std::make_unique<InstanceCuller>(m_shaderManager, m_beatMesh.get());
+    resetTrack(0);
+    m_debrisSystem = std::make_unique<DebrisSystem>(m_shaderManager, m_transparencyPass.get(), m_beatMesh.get());
     updateCamera(true);
 }
 
@@ -395,18 +388,25 @@ void World::resize(int width, int height)
 {
     m_camera->setAspectRatio(static_cast<float>(width) / height);
     m_renderer->resize(width, height);
+    m_sceneFramebuffer->resize(width, height);
+    m_transparencyPass->resize(width, height);
 }
 
 void World::update(InputState inputState, float elapsed)
 {
     m_player->update();
     m_trackTime += elapsed;
+    extendTrack(PathGenerator::Speed * (m_trackTime + PathGenerator::LookAhead));
+    retireTrack(PathGenerator::Speed * m_trackTime - PathGenerator::MarginBehind);
     updateCamera(false);
     updateBeats(inputState);
-    updateDebris(elapsed);
+    placeBeats();
+    m_pathRibbons->updatePath(m_path);
+    m_debrisSystem->update(elapsed, m_camera->frustum());
     updateParticles(elapsed);
     updateTextAnimations(elapsed);
     m_comboCounter->update(elapsed);
+    updateCullStats(elapsed);
 
     // HACK why no restart
     if (m_player->state() != OggPlayer::State::Playing) {
@@ -416,8 +416,8 @@ void World::update(InputState inputState, float elapsed)
 
 void World::updateCamera(bool snapToPosition)
 {
-    const auto distance = Speed * m_trackTime;
-    const auto state = pathStateAt(distance);
+    const auto distance = PathGenerator::Speed * m_trackTime;
+    const auto state = m_cameraPathCursor.stateAt(distance);
 
     const auto transform = state.transformMatrix();
 
@@ -464,111 +464,116 @@ void World::updateBeats(InputState inputState)
         return -.5 * Width + track * Width / (m_track->eventTracks - 1);
     };
 
-    for (auto &beat : m_beats) {
-        bool hit = false, miss = false, spawnDebris = false;
-        float hitDeltaT = 0.0f;
-
-        switch (beat->state) {
-        case Beat::State::Active: {
-            if (pressed(trackInputs[beat->track])) {
-                // hit start of beat?
-                hitDeltaT = std::abs(beat->start - m_trackTime);
-                if (hitDeltaT < HitWindow) {
-                    hit = true;
-                    if (beat->type == Beat::Type::Tap) {
-                        beat->state = Beat::State::Inactive;
-                        spawnDebris = true;
-                    } else {
-                        beat->state = Beat::State::Holding;
+    for (auto &lane : m_lanes) {
+        // beats starting after m_trackTime + HitWindow can't be hit or missed yet
+        const auto windowEnd = lane.advance(
+                [this](unsigned index) { return !m_beats.alive[index]; },
+                [this](unsigned index) { return m_beats.start[index]; },
+                m_trackTime + HitWindow);
+        for (auto i = lane.head; i < windowEnd; ++i) {
+            const auto index = lane.beats[i];
+            const auto type = m_beats.type[index];
+            const auto track = m_beats.track[index];
+            const auto start = m_beats.start[index];
+            const auto end = start + m_beats.duration[index];
+
+            auto state = m_beats.state(index);
+            bool hit = false, miss = false, spawnDebris = false;
+            float hitDeltaT = 0.0f;
+
+            switch (state) {
+            case Beats::State::Active: {
+                if (pressed(trackInputs[track])) {
+                    // hit start of beat?
+                    hitDeltaT = std::abs(start - m_trackTime);
+                    if (hitDeltaT < HitWindow) {
+                        hit = true;
+                        if (type == Beats::Type::Tap) {
+                            state = Beats::State::Inactive;
+                            spawnDebris = true;
+                        } else {
+                            state = Beats::State::Holding;
+                        }
                     }
-                }
-            } else {
-                // missed start of beat?
-                if (beat->start < m_trackTime - HitWindow) {
-                    miss = true;
-                    if (beat->type == Beat::Type::Tap) {
-                        beat->state = Beat::State::Inactive;
-                    } else {
-                        beat->state = Beat::State::HoldMissed;
+                } else {
+                    // missed start of beat?
+                    if (start < m_trackTime - HitWindow) {
+                        miss = true;
+                        if (type == Beats::Type::Tap) {
+                            state = Beats::State::Inactive;
+                        } else {
+                            state = Beats::State::HoldMissed;
+                        }
                     }
                 }
+                break;
             }
-            break;
-        }
 
-        case Beat::State::Holding: {
-            if (released(trackInputs[beat->track])) {
-                // released on end of beat?
-                hitDeltaT = std::abs(beat->start + beat->duration - m_trackTime);
-                if (hitDeltaT < HitWindow) {
-                    hit = true;
-                    beat->state = Beat::State::Inactive;
+            case Beats::State::Holding: {
+                if (released(trackInputs[track])) {
+                    // released on end of beat?
+                    hitDeltaT = std::abs(end - m_trackTime);
+                    if (hitDeltaT < HitWindow) {
+                        hit = true;
+                        state = Beats::State::Inactive;
+                    } else {
+                        // released too early
+                        miss = true;
+                        state = Beats::State::HoldMissed;
+                    }
                 } else {
-                    // released too early
-                    miss = true;
-                    beat->state = Beat::State::HoldMissed;
+                    // missed end of beat?
+                    if (end < m_trackTime - HitWindow) {
+                        state = Beats::State::Inactive;
+                        miss = true;
+                    }
                 }
-            } else {
-                // missed end of beat?
-                if (beat->start + beat->duration < m_trackTime - HitWindow) {
-                    beat->state = Beat::State::Inactive;
-                    miss = true;
+                break;
+            }
+
+            case Beats::State::HoldMissed: {
+                if (end < m_trackTime) {
+                    state = Beats::State::Inactive;
                 }
+                break;
             }
-            break;
-        }
 
-        case Beat::State::HoldMissed: {
-            if (beat->start + beat->duration < m_trackTime) {
-                beat->state = Beat::State::Inactive;
+            case Beats::State::Inactive:
+                break;
             }
-            break;
-        }
 
-        case Beat::State::Inactive:
-            break;
-        }
+            m_beats.setState(index, state);
+            if (type == Beats::Type::Tap && state == Beats::State::Inactive)
+                m_tapCuller->setInstanceEnabled(m_beats.data[index], false);
 
-        if (hit) {
-            m_comboCounter->increment();
-            const float score = hitDeltaT / HitWindow;
-            std::u32string animationText;
-            if (score < 0.25) {
-                m_hudAnimations.emplace_back(new HitAnimation(textPosition(beat->track), -50, U"PERFECT!"s));
-            } else {
-                m_hudAnimations.emplace_back(new HitAnimation(textPosition(beat->track), -50, U"GOOD"s));
+            if (hit) {
+                m_comboCounter->increment();
+                const float score = hitDeltaT / HitWindow;
+                std::u32string animationText;
+                if (score < 0.25) {
+                    m_hudAnimations.emplace_back(new HitAnimation(textPosition(track), -50, U"PERFECT!"s));
+                } else {
+                    m_hudAnimations.emplace_back(new HitAnimation(textPosition(track), -50, U"GOOD"s));
+                }
             }
-        }
 
-        if (miss) {
-            m_comboCounter->clear();
-            m_hudAnimations.emplace_back(new HitAnimation(textPosition(beat->track), 200, U"MISSED"s));
-        }
+            if (miss) {
+                m_comboCounter->clear();
+                m_hudAnimations.emplace_back(new HitAnimation(textPosition(track), 200, U"MISSED"s));
+            }
 
-        if (spawnDebris) {
-            assert(beat->type == Beat::Type::Tap);
-            // FIXME can't just get the submatrix for rotation etc, transform is scaled!
-            // it's 4:00 AM right now but fix me later
-#if 0
-            const glm::vec3 position = glm::vec3(beat->transform[3]);
-            const glm::mat3 rotation = glm::mat3(beat->transform);
-            const glm::vec3 velocity = 0.1f * glm::vec3(beat->transform[1]);
-#endif
-            glm::vec3 scale;
-            glm::quat rotation;
-            glm::vec3 translation;
-            glm::vec3 skew;
-            glm::vec4 perspective;
-            glm::decompose(beat->transform, scale, rotation, translation, skew, perspective);
-            const auto rotationMatrix = glm::mat3_cast(rotation);
-            const glm::vec3 velocity = 0.5f * glm::vec3(rotationMatrix[0]);
-
-            // rotation axis any random vector orthogonal to direction
-            glm::vec3 u = glm::ballRand(1.0f);
-            glm::vec3 rotationAxis = glm::cross(u, rotationMatrix[0]);
-            float angularSpeed = glm::linearRand(5.0f, 10.0f);
-
-            m_debris.push_back(Debris { beat->track, translation, rotationMatrix, scale, velocity, rotationAxis, angularSpeed, 0, 3 });
+            if (spawnDebris) {
+                assert(type == Beats::Type::Tap);
+                const auto state = m_path.stateAt(PathGenerator::Speed * start);
+
+                constexpr auto UsableTrackWidth = static_cast<float>(720) * TrackWidth / 800;
+                const auto laneWidth = UsableTrackWidth / m_track->eventTracks;
+                const auto laneX = -0.5f * UsableTrackWidth + (track + 0.5f) * laneWidth;
+
+                const auto position = state.center + laneX * state.side();
+                const auto velocity = 0.5f * state.up();
+                m_debrisSystem->spawnDebris(track, position, state.orientation, 0.4f * laneWidth, velocity);
+            }
         }
     }
 
@@ -585,21 +590,58 @@ void World::updateBeats(InputState inputState)
     m_prevInputState = inputState;
 }
 
-void World::updateDebris(float elapsed)
+// taps get their transform, holds get the path generated up to their end as it may be past LookAhead;
+// the taps' path states are looked up a batch at a time, their distances being increasing
+void World::placeBeats()
 {
-    auto it = m_debris.begin();
-    while (it != m_debris.end()) {
-        auto &debris = *it;
-        debris.time += elapsed;
-        if (debris.time >= debris.life) {
-            it = m_debris.erase(it);
-        } else {
-            debris.position += elapsed * debris.velocity;
-            auto rotation = glm::rotate(glm::mat4(1), elapsed * debris.angularSpeed, debris.rotationAxis);
-            debris.orientation *= glm::mat3(rotation);
-            ++it;
+    constexpr std::size_t BatchSize = 64;
+    std::array<std::size_t, BatchSize> taps;
+    std::array<float, BatchSize> distances;
+    std::array<PathState, BatchSize> states;
+    std::size_t count = 0;
+
+    const auto placeTaps = [&] {
+        m_beatPathCursor.statesAt(distances.data(), count, states.data());
+
+        constexpr auto UsableTrackWidth = static_cast<float>(720) * TrackWidth / 800;
+        const auto laneWidth = UsableTrackWidth / m_track->eventTracks;
+        const auto scale = glm::scale(glm::mat4(1), glm::vec3(0.4f * laneWidth));
+        for (std::size_t i = 0; i < count; ++i) {
+            const auto index = taps[i];
+            const auto laneX = -0.5f * UsableTrackWidth + (m_beats.track[index] + 0.5f) * laneWidth;
+            const auto translate = glm::translate(glm::mat4(1), glm::vec3(0, laneX, 0));
+            m_tapCuller->setInstance(m_beats.data[index], states[i].transformMatrix() * translate * scale);
         }
+        count = 0;
+    };
+
+    for (; m_nextBeatToPlace < m_beats.size() && m_beats.start[m_nextBeatToPlace] < m_trackTime + PathGenerator::LookAhead; ++m_nextBeatToPlace) {
+        const auto index = m_nextBeatToPlace;
+        if (!m_beats.alive[index])
+            continue;
+        if (m_beats.type[index] == Beats::Type::Hold) {
+            extendTrack(PathGenerator::Speed * (m_beats.start[index] + m_beats.duration[index]));
+            continue;
+        }
+        taps[count] = index;
+        distances[count] = PathGenerator::Speed * m_beats.start[index];
+        if (++count == BatchSize)
+            placeTaps();
     }
+    if (count != 0)
+        placeTaps();
+}
+
+void World::updateCullStats(float elapsed)
+{
+    m_cullStatsTime += elapsed;
+    if (m_cullStatsTime < CullStatsInterval)
+        return;
+    const auto &stats = m_renderer->cullStats();
+    spdlog::debug("Frustum culling: {}/{} draw calls, {}/{} debris culled",
+                  stats.culled, stats.tested, m_debrisSystem->culledCount(), m_debrisSystem->debrisCount());
+    m_renderer->resetCullStats();
+    m_cullStatsTime = 0.0f;
 }
 
 void World::updateParticles(float elapsed)
@@ -643,110 +685,91 @@ void World::render() const
     m_camera->setEye(glm::vec3(0, 0, 15));
     m_camera->setCenter(glm::vec3(0, 0, 0));
     m_camera->setUp(glm::vec3(0, 1, 0));
-
-    const auto angle = 0.5f * m_trackTime;
-    const auto modelMatrix = glm::rotate(glm::mat4(1), angle, glm::vec3(0, 1, 0));
-#else
-    const auto modelMatrix = glm::mat4(1);
 #endif
 
     m_shaderManager->clearCurrentProgram();
 
-    m_shaderManager->useProgram(ShaderManager::DecalFog);
-    m_shaderManager->setUniform(ShaderManager::Eye, m_camera->eye());
-    m_shaderManager->setUniform(ShaderManager::FogColor, glm::vec4(0, 0, 0, 1));
-    m_shaderManager->setUniform(ShaderManager::FogDistance, glm::vec2(.1, 5.));
+    ShaderManager::FrameUniforms frameUniforms;
+    frameUniforms.viewMatrix = m_camera->viewMatrix();
+    frameUniforms.projectionMatrix = m_camera->projectionMatrix();
+    frameUniforms.eye = m_camera->eye();
+    frameUniforms.lightPosition = glm::vec3(0, 10, -10);
+    frameUniforms.fogColor = glm::vec4(0, 0, 0, 1);
+    frameUniforms.fogDistance = glm::vec2(FogNear, FogFar);
+    frameUniforms.clipPlane = m_clipPlane;
+    m_shaderManager->setFrameUniforms(frameUniforms);
 
-    m_shaderManager->useProgram(ShaderManager::LightingFog);
-    m_shaderManager->setUniform(ShaderManager::LightPosition, glm::vec3(0, 10, -10));
-    m_shaderManager->setUniform(ShaderManager::Eye, m_camera->eye());
-    m_shaderManager->setUniform(ShaderManager::FogColor, glm::vec4(0, 0, 0, 1));
-    m_shaderManager->setUniform(ShaderManager::FogDistance, glm::vec2(.1, 5.));
+    m_sceneFramebuffer->bind();
+    m_transparencyPass->clear();
 
-    m_shaderManager->useProgram(ShaderManager::LightingFogClip);
-    m_shaderManager->setUniform(ShaderManager::LightPosition, glm::vec3(0, 10, -10));
-    m_shaderManager->setUniform(ShaderManager::Eye, m_camera->eye());
-    m_shaderManager->setUniform(ShaderManager::FogColor, glm::vec4(0, 0, 0, 1));
-    m_shaderManager->setUniform(ShaderManager::FogDistance, glm::vec2(.1, 5.));
-    m_shaderManager->setUniform(ShaderManager::ClipPlane, m_clipPlane);
+    // only look at what's within fog distance along the path; assumes the path doesn't loop back
+    // closer than that, as everything is looked up by path distance
 
-    m_shaderManager->useProgram(ShaderManager::LightingFogBlend);
-    m_shaderManager->setUniform(ShaderManager::LightPosition, glm::vec3(0, 10, -10));
-    m_shaderManager->setUniform(ShaderManager::Eye, m_camera->eye());
-    m_shaderManager->setUniform(ShaderManager::FogColor, glm::vec4(0, 0, 0, 1));
-    m_shaderManager->setUniform(ShaderManager::FogDistance, glm::vec2(.1, 5.));
+    const auto cameraDistance = PathGenerator::Speed * m_trackTime;
+    const auto minDistance = cameraDistance - PathGenerator::MarginBehind;
+    const auto maxDistance = cameraDistance + FogFar;
 
-    m_shaderManager->useProgram(ShaderManager::Billboard);
-    m_shaderManager->setUniform(ShaderManager::Eye, m_camera->eye());
+    const auto lastBeat = m_beats.range(minDistance / PathGenerator::Speed, maxDistance / PathGenerator::Speed).second;
 
-    // sort track segments back-to-front for proper transparency
+    // hold note bodies are extruded along the path on the GPU, opaque so they go first
 
-    std::vector<std::tuple<float, const Mesh *>> trackSegments;
-    trackSegments.reserve(m_trackSegments.size());
+    const auto holdParts = [this](std::size_t index) {
+        return m_path.partCount(PathGenerator::Speed * m_beats.start[index], PathGenerator::Speed * (m_beats.start[index] + m_beats.duration[index]));
+    };
 
-    const auto cameraDir = glm::normalize(m_camera->center() - m_camera->eye());
+    glDisable(GL_BLEND);
 
-    std::transform(m_trackSegments.begin(), m_trackSegments.end(), std::back_inserter(trackSegments),
-                   [this, &cameraDir](const TrackSegment &segment) {
-                       const auto z = glm::dot(segment.position - m_camera->eye(), cameraDir);
-                       return std::make_tuple(z, segment.mesh.get());
-                   });
+    constexpr auto npos = boost::dynamic_bitset<>::npos;
 
-    std::sort(trackSegments.begin(), trackSegments.end(), [](const auto &lhs, const auto &rhs) {
-        return std::get<0>(lhs) > std::get<0>(rhs);
-    });
+    for (auto i = m_beats.holding.find_first(); i != npos; i = m_beats.holding.find_next(i)) {
+        assert(m_beats.type[i] == Beats::Type::Hold);
+        float t = m_trackTime - m_beats.start[i];
+        float alpha = 0.5f + 0.5f * sin(5.0f * t);
+        m_shaderManager->useProgram(ShaderManager::RibbonLightingFogBlend);
+        m_shaderManager->setUniform(ShaderManager::BlendColor, glm::vec4(1, 1, 1, alpha));
+        beatMaterial(m_beats.track[i])->texture->bind();
+        m_pathRibbons->render(m_beats.data[i], 1, holdParts(i));
+    }
 
-    // sigh.... special case: long notes
-    // our renderer sucks
-
-    bool renderedLongNote = false;
-
-    for (const auto &beat : m_beats) {
-        if (beat->type == Beat::Type::Hold) {
-            if (beat->state == Beat::State::Holding) {
-                float t = m_trackTime - beat->start;
-                float alpha = 0.5f + 0.5f * sin(5.0f * t);
-                m_shaderManager->useProgram(ShaderManager::LightingFogBlend);
-                m_shaderManager->setUniform(ShaderManager::BlendColor, glm::vec4(1, 1, 1, alpha));
-                m_renderer->begin();
-                m_renderer->render(beat->mesh.get(), longNoteMaterial(beat->track), glm::mat4(1));
-                m_renderer->end();
-            } else if (beat->state == Beat::State::HoldMissed) {
-                m_shaderManager->useProgram(ShaderManager::LightingFogBlend);
-                m_shaderManager->setUniform(ShaderManager::BlendColor, glm::vec4(.5, .5, .5, 0.75));
-                m_renderer->begin();
-                m_renderer->render(beat->mesh.get(), longNoteMaterial(beat->track), glm::mat4(1));
-                m_renderer->end();
-            }
+    for (auto i = m_beats.holdMissed.find_first(); i != npos; i = m_beats.holdMissed.find_next(i)) {
+        assert(m_beats.type[i] == Beats::Type::Hold);
+        m_shaderManager->useProgram(ShaderManager::RibbonLightingFogBlend);
+        m_shaderManager->setUniform(ShaderManager::BlendColor, glm::vec4(.5, .5, .5, 0.75));
+        beatMaterial(m_beats.track[i])->texture->bind();
+        m_pathRibbons->render(m_beats.data[i], 1, holdParts(i));
+    }
+
+    // the other ones, a draw call per run of consecutive ribbons in each lane
+    m_shaderManager->useProgram(ShaderManager::RibbonLightingFog);
+    for (std::size_t track = 0; track < m_lanes.size(); ++track) {
+        beatMaterial(track)->texture->bind();
+        std::size_t first = 0, count = 0, parts = 0;
+        const auto flush = [this, &first, &count, &parts] {
+            m_pathRibbons->render(first, count, parts);
+            count = parts = 0;
+        };
+        const auto &lane = m_lanes[track];
+        for (auto it = lane.beats.begin() + lane.head; it != lane.beats.end() && *it < lastBeat; ++it) {
+            const auto i = *it;
+            if (m_beats.type[i] != Beats::Type::Hold || !m_beats.alive[i] || m_beats.holding[i] || m_beats.holdMissed[i])
+                continue;
+            if (count != 0 && m_beats.data[i] != first + count)
+                flush();
+            if (count == 0)
+                first = m_beats.data[i];
+            ++count;
+            parts = std::max(parts, holdParts(i));
         }
+        flush();
     }
 
     // now render everything
 
     m_renderer->begin();
 
-    for (const auto &segment : trackSegments) {
-        m_renderer->render(std::get<1>(segment), trackMaterial(), modelMatrix);
-    }
-    for (const auto &beat : m_beats) {
-        if (beat->state == Beat::State::Inactive)
-            continue;
-        if (beat->type == Beat::Type::Tap) {
-            m_renderer->render(m_beatMesh.get(), beatMaterial(beat->track), beat->transform);
-        } else {
-            assert(beat->mesh);
-            if (beat->state != Beat::State::Holding && beat->state != Beat::State::HoldMissed) {
-                m_renderer->render(beat->mesh.get(), beatMaterial(beat->track), glm::mat4(1));
-            }
-        }
-    }
-    for (const auto &debris : m_debris) {
-        const auto rotate = glm::mat4(debris.orientation);
-        const auto translate = glm::translate(glm::mat4(1), debris.position);
-        const auto scale = glm::scale(glm::mat4(1), debris.scale);
-        const auto transform = translate * scale * rotate;
-        m_renderer->render(m_beatMesh.get(), debrisMaterial(debris.track), transform);
-    }
+    // every tap note that was placed and is still alive, visibility is left to the GPU
+    m_tapCuller->cull();
+    m_renderer->render(m_tapCuller.get());
 
 #if 0
         m_renderer->render(m_markerMesh.get(), debugMaterial(), m_markerTransform);
@@ -768,7 +791,20 @@ void World::render() const
 
     m_renderer->end();
 
+    // the track is a single ribbon over the visible part of the path
+    const PathRibbons::Ribbon trackRibbon = { minDistance, maxDistance, 0.0f, 0.5f * TrackWidth, 0.0f, 0.0f, 3.0f };
+    m_pathRibbons->setRibbons(0, &trackRibbon, 1);
+    m_transparencyPass->begin();
+    m_shaderManager->useProgram(ShaderManager::RibbonLightingFogTransparent);
+    trackTexture()->bind();
+    m_pathRibbons->render(0, 1, m_path.partCount(minDistance, maxDistance));
+    m_transparencyPass->end();
+
+    m_debrisSystem->render();
+    m_transparencyPass->composite();
     m_particleSystem->render(m_markerTransform);
+
+    m_sceneFramebuffer->resolve();
 }
 
 static std::u32string timeToString(float t)
@@ -796,146 +832,30 @@ void World::renderHUD(HUDPainter *hudPainter) const
     m_comboCounter->render(hudPainter);
 }
 
-World::PathState World::pathStateAt(float distance) const
+void World::resetTrack(unsigned seed)
 {
-    // reference: https://i.kym-cdn.com/photos/images/newsfeed/000/234/765/b7e.jpg
-
-    const auto partIndex = [this, distance]() -> std::size_t {
-        auto it = std::upper_bound(
-                m_pathParts.begin(), m_pathParts.end(),
-                distance,
-                [](float distance, const auto &part) {
-                    return distance < part.distance;
-                });
-        if (it == m_pathParts.begin())
-            return 0;
-        return std::distance(m_pathParts.begin(), it) - 1;
-    }();
-
-    assert(partIndex < m_pathParts.size() - 1);
-
-    const auto &curPart = m_pathParts[partIndex];
-    const auto &nextPart = m_pathParts[partIndex + 1];
-
-    assert(distance >= curPart.distance && distance < nextPart.distance);
-
-    const float t = (distance - curPart.distance) / (nextPart.distance - curPart.distance);
-    assert(t >= 0.0f && t < 1.0f);
-
-    const auto center = glm::mix(curPart.state.center, nextPart.state.center, t);
-
-    const auto q0 = glm::quat_cast(curPart.state.orientation);
-    const auto q1 = glm::quat_cast(nextPart.state.orientation);
-    const auto q = glm::mix(q0, q1, t);
-    const auto orientation = glm::mat3_cast(q);
-
-    return { orientation, center };
+    m_pathGenerator.reset(seed);
+    m_path.clear();
+    extendTrack(PathGenerator::Speed * PathGenerator::LookAhead);
+    m_pathRibbons->updatePath(m_path);
 }
 
-static void initializeSegment(std::vector<glm::vec3> &vertices, const glm::vec3 &from, const glm::vec3 &to, int level)
+// generates the path up to distance (at least)
+void World::extendTrack(float distance)
 {
-    if (level == 0) {
-        vertices.push_back(from);
-        return;
-    }
-
-    const auto dist = glm::distance(to, from);
-    const auto perturb = glm::linearRand(0.25f, .5f) * dist;
-
-    // perturb midpoint along a random vector orthogonal to the segment direction
-    const auto dir = glm::normalize(to - from);
-    const auto side = glm::sphericalRand(1.0f);
-    const auto up = glm::normalize(glm::cross(dir, side));
-
-    const auto mid = 0.5f * (from + to) + perturb * up;
-
-    initializeSegment(vertices, from, mid, level - 1);
-    initializeSegment(vertices, mid, to, level - 1);
+    while (m_path.size() < 2 || m_path.endDistance() < distance)
+        m_pathGenerator.generateChunk(m_path);
 }
 
-void World::initializeTrackMesh()
+// drops the path entirely behind distance
+void World::retireTrack(float distance)
 {
-    std::vector<glm::vec3> controlPoints;
-    initializeSegment(controlPoints, glm::vec3(-10, 0, 0), glm::vec3(10, 0, 0), 5);
-
-    glm::vec3 currentUp(0, 0, 1);
-    std::optional<glm::vec3> prevCenter;
-    float distance = 0.0f;
-
-    for (size_t i = 1, size = controlPoints.size() - 1; i < size; ++i) {
-        const auto prev = controlPoints[i - 1];
-        const auto cur = controlPoints[i];
-        const auto next = controlPoints[i + 1];
-
-        const auto path = Bezier { 0.5f * (prev + cur), cur, 0.5f * (cur + next) };
-
-        constexpr auto PartsPerSegment = 20;
-        for (size_t j = 0; j < PartsPerSegment; ++j) {
-            const auto t = static_cast<float>(j) / PartsPerSegment;
-
-            const auto center = path.eval(t);
-
-            if (prevCenter != std::nullopt)
-                distance += glm::distance(*prevCenter, center);
-
-            const auto dir = glm::normalize(path.direction(t));
-            const auto side = glm::normalize(glm::cross(dir, currentUp));
-            const auto up = glm::normalize(glm::cross(side, dir));
-
-            const auto orientation = glm::mat3(up, side, dir);
-
-            m_pathParts.push_back(PathPart { { orientation, center }, distance });
-
-            currentUp = up;
-            prevCenter = center;
-        }
-    }
-
-    constexpr auto VertsPerSegment = 10;
-
-    for (size_t i = 0, size = m_pathParts.size(); i < size; i += VertsPerSegment) {
-        std::vector<MeshVertex> vertices;
-        for (size_t j = i, end = std::min(size - 1, i + VertsPerSegment); j <= end; ++j) {
-            const auto &part = m_pathParts[j];
-            const auto texU = 3.0f * part.distance;
-            vertices.push_back({ part.state.center - part.state.side() * 0.5f * TrackWidth, glm::vec2(0.0f, texU), part.state.up() });
-            vertices.push_back({ part.state.center + part.state.side() * 0.5f * TrackWidth, glm::vec2(1.0f, texU), part.state.up() });
-        }
-        auto mesh = makeMesh(vertices, GL_TRIANGLE_STRIP);
-
-        glm::vec3 position = glm::vec3(0.0);
-        for (auto &vertex : vertices) {
-            position += vertex.position;
-        }
-        position *= 1.0f / vertices.size();
-
-        m_trackSegments.push_back({ position, std::move(mesh) });
-    }
-
-    spdlog::info("Initialized track, length={} segments={} parts={}",
-                 distance, m_trackSegments.size(), m_pathParts.size());
+    m_path.discardBefore(distance);
 }
 
 void World::initializeBeatMeshes()
 {
-    m_beatMesh = loadMesh(meshPath("beat.obj"));
-}
-
-static std::unique_ptr<Mesh> makeDebugMesh(const std::vector<glm::vec3> &vertices, GLenum primitive = GL_TRIANGLE_STRIP)
-{
-    static const std::vector<Mesh::VertexAttribute> attributes = {
-        { 3, GL_FLOAT, 0 }
-    };
-
-    auto mesh = std::make_unique<Mesh>(primitive);
-    mesh->setVertexCount(vertices.size());
-    mesh->setVertexSize(sizeof(glm::vec3));
-    mesh->setVertexAttributes(attributes);
-
-    mesh->initialize();
-    mesh->setVertexData(vertices.data());
-
-    return mesh;
+    m_beatMesh = loadMesh(m_meshArena.get(), meshPath("beat.obj"));
 }
 
 void World::initializeMarkerMesh()
@@ -949,14 +869,15 @@ void World::initializeMarkerMesh()
     constexpr auto Bottom = -0.5f * Thick;
     constexpr auto Top = 0.5f * Thick;
 
-    static const std::vector<glm::vec3> vertices = {
-        { Height, Left, Bottom },
-        { Height, Right, Bottom },
-        { Height, Left, Top },
-        { Height, Right, Top },
+    // the debug program only reads positions
+    static const std::vector<MeshVertex> vertices = {
+        { { Height, Left, Bottom }, { 0, 0 }, { 1, 0, 0 } },
+        { { Height, Right, Bottom }, { 0, 0 }, { 1, 0, 0 } },
+        { { Height, Left, Top }, { 0, 0 }, { 1, 0, 0 } },
+        { { Height, Right, Top }, { 0, 0 }, { 1, 0, 0 } },
     };
 
-    m_markerMesh = makeDebugMesh(vertices);
+    m_markerMesh = makeMesh(m_meshArena.get(), vertices, GL_TRIANGLE_STRIP);
 }
 
 void World::initializeButtonMesh()
@@ -967,7 +888,7 @@ void World::initializeButtonMesh()
         { { 0, -1, 1 }, { 0, 1 }, { 1, 0, 0 } },
         { { 0, 1, 1 }, { 1, 1 }, { 1, 0, 0 } },
     };
-    m_buttonMesh = makeMesh(vertices, GL_TRIANGLE_STRIP);
+    m_buttonMesh = makeMesh(m_meshArena.get(), vertices, GL_TRIANGLE_STRIP);
 }
 
 void World::setTrack(const Track *track)
@@ -977,113 +898,142 @@ void World::setTrack(const Track *track)
 
 void World::initializeLevel()
 {
-    m_beats.clear();
-    const auto &events = m_track->events;
-    std::transform(events.begin(), events.end(), std::back_inserter(m_beats),
-                   [this](const Track::Event &event) -> std::unique_ptr<Beat> {
-                       const auto distance = Speed * event.start;
-
-                       const auto pathState = pathStateAt(distance);
-
-                       constexpr auto UsableTrackWidth = static_cast<float>(720) * TrackWidth / 800;
-                       const auto laneWidth = UsableTrackWidth / m_track->eventTracks;
-                       const auto laneX = -0.5f * UsableTrackWidth + (event.track + 0.5f) * laneWidth;
-
-                       auto beat = std::make_unique<Beat>();
-
-                       beat->type = static_cast<Beat::Type>(event.type);
-                       beat->start = event.start;
-                       beat->duration = event.duration;
-                       beat->track = event.track;
-
-                       if (event.type == Track::Event::Type::Tap) {
-                           const auto translate = glm::translate(glm::mat4(1), glm::vec3(0, laneX, 0));
-                           const auto scale = glm::scale(glm::mat4(1), glm::vec3(0.4f * laneWidth));
-                           beat->transform = pathState.transformMatrix() * translate * scale;
-                       } else {
-                           beat->transform = glm::mat4(1);
-
-                           const auto from = Speed * event.start;
-                           const auto to = Speed * (event.start + event.duration);
-
-                           constexpr auto Height = 0.01f;
-                           constexpr auto BevelFraction = 0.3f;
-
-                           const auto radius = 0.4f * laneWidth;
-                           const auto smallRadius = (1.0f - BevelFraction) * radius;
-
-                           std::vector<MeshVertex> vertices;
-
-                           const auto addCap = [this, &vertices, radius, smallRadius, laneX, Height](float distance) {
-                               const auto state = pathStateAt(distance);
-                               const auto transform = state.transformMatrix();
-
-                               const auto n = state.up();
-
-                               const std::vector<glm::vec2> localVertices = {
-                                   { -smallRadius, -radius },
-                                   { smallRadius, -radius },
-                                   { -radius, -smallRadius },
-                                   { radius, -smallRadius },
-                                   { -radius, smallRadius },
-                                   { radius, smallRadius },
-                                   { -smallRadius, radius },
-                                   { smallRadius, radius },
-                               };
-
-                               for (const auto &v : localVertices) {
-                                   vertices.push_back({ glm::vec3(transform * glm::vec4(Height, v.x + laneX, v.y, 1)), { 0, 0 }, n });
-                               }
-                           };
-
-                           addCap(from);
-
-                           const auto vLeft = glm::vec4(Height, laneX - smallRadius, 0.0f, 1.0f);
-                           const auto vRight = glm::vec4(Height, laneX + smallRadius, 0.0f, 1.0f);
-
-                           const auto addVertices = [this, &vertices, vLeft, vRight](float distance) {
-                               const auto state = pathStateAt(distance);
-                               const auto transform = state.transformMatrix();
-                               const auto n = state.up();
-                               vertices.push_back({ glm::vec3(transform * vLeft), { 0, 0 }, n });
-                               vertices.push_back({ glm::vec3(transform * vRight), { 0, 0 }, n });
-                           };
+    auto events = m_track->events;
+    std::stable_sort(events.begin(), events.end(), [](const Track::Event &lhs, const Track::Event &rhs) {
+        return lhs.start < rhs.start;
+    });
 
-                           constexpr auto DistanceDelta = 0.1f;
-                           for (float d = from + radius; d < to - radius; d += DistanceDelta) {
-                               addVertices(d);
-                           }
+    m_beats.clear();
+    for (const auto &event : events) {
+        const auto type = static_cast<Beats::Type>(event.type);
+        m_beats.add(type, event.track, event.start, event.duration, 0); // data is set below, once sorted by lane
+    }
 
-                           addCap(to);
+    // m_beats is sorted by start time, so are the lanes
+    m_lanes.clear();
+    m_lanes.resize(m_track->eventTracks);
+    for (unsigned i = 0, size = m_beats.size(); i < size; ++i) {
+        const auto track = m_beats.track[i];
+        assert(track < m_lanes.size());
+        m_lanes[track].beats.push_back(i);
+    }
 
-                           spdlog::info("created mesh for long note: {} vertices", vertices.size());
+    // hold note bodies never change, their ribbons are set up once: grouped by lane and sorted by start
+    // time, so the ones in view are mostly drawn in a single call per lane
+    constexpr auto UsableTrackWidth = static_cast<float>(720) * TrackWidth / 800;
+    const auto laneWidth = UsableTrackWidth / m_track->eventTracks;
+    const auto radius = 0.4f * laneWidth;
+    constexpr auto Height = 0.01f;
+    constexpr auto BevelFraction = 0.3f;
+
+    std::vector<PathRibbons::Ribbon> holdRibbons;
+    std::vector<const Material *> tapMaterials;
+    for (std::size_t track = 0; track < m_lanes.size(); ++track) {
+        const auto laneX = -0.5f * UsableTrackWidth + (track + 0.5f) * laneWidth;
+        for (const auto i : m_lanes[track].beats) {
+            if (m_beats.type[i] != Beats::Type::Hold)
+                continue;
+            m_beats.data[i] = 1 + holdRibbons.size(); // ribbon 0 is the track
+            const auto start = PathGenerator::Speed * m_beats.start[i];
+            const auto end = PathGenerator::Speed * (m_beats.start[i] + m_beats.duration[i]);
+            holdRibbons.push_back({ start, end, laneX, radius, BevelFraction * radius, Height, 0.0f });
+        }
+        tapMaterials.push_back(beatMaterial(track));
+    }
 
-                           beat->mesh = makeMesh(vertices, GL_TRIANGLE_STRIP);
-                       }
+    // tap notes are numbered by start time, so the ones in play are a short run of instances for the
+    // culler to test; each is in the group of its lane's material
+    std::vector<unsigned> tapGroups;
+    for (std::size_t i = 0; i < m_beats.size(); ++i) {
+        if (m_beats.type[i] != Beats::Type::Tap)
+            continue;
+        m_beats.data[i] = tapGroups.size(); // placed once the path gets there, see placeBeats
+        tapGroups.push_back(m_beats.track[i]);
+    }
+    m_tapCuller->setGroups(tapMaterials, tapGroups);
+    m_pathRibbons->setRibbonCount(1 + holdRibbons.size());
+    m_pathRibbons->setRibbons(1, holdRibbons.data(), holdRibbons.size());
 
-                       beat->state = Beat::State::Active;
+    m_nextBeatToPlace = 0;
+    m_debrisSystem->clear();
+    placeBeats();
+    m_pathRibbons->updatePath(m_path);
 
-                       return beat;
-                   });
     spdlog::info("drawing {} beats", m_beats.size());
 }
 
 void World::startGame()
 {
     m_trackTime = 0.0f;
+    resetTrack(static_cast<unsigned>(std::hash<std::string>()(m_track->audioFile)));
+    updateCamera(true);
     initializeLevel();
     m_player->open(m_track->audioFile);
     m_player->play();
 }
 
-glm::mat4 World::PathState::transformMatrix() const
+bool World::isPlaying() const
 {
-    const auto translate = glm::translate(glm::mat4(1), center);
-    const auto rotation = glm::mat4(orientation);
-    return translate * rotation;
+    return m_player->state() == OggPlayer::State::Playing;
 }
 
-bool World::isPlaying() const
+void World::toggleParticleBillboardMode()
 {
-    return m_player->state() == OggPlayer::State::Playing;
+    using BillboardMode = ParticleSystem::BillboardMode;
+    const auto mode = m_particleSystem->billboardMode() == BillboardMode::GeometryShader ? BillboardMode::InstancedQuads : BillboardMode::GeometryShader;
+    m_particleSystem->setBillboardMode(mode);
+    spdlog::info("Particle billboards: {}", mode == BillboardMode::GeometryShader ? "geometry shader" : "instanced quads");
+}
+
+void World::Beats::clear()
+{
+    start.clear();
+    duration.clear();
+    track.clear();
+    type.clear();
+    data.clear();
+    alive.clear();
+    holding.clear();
+    holdMissed.clear();
+    maxDuration = 0.0f;
+}
+
+void World::Beats::add(Type type, int track, float start, float duration, unsigned data)
+{
+    assert(size() == 0 || this->start.back() <= start);
+    this->start.push_back(start);
+    this->duration.push_back(duration);
+    this->track.push_back(track);
+    this->type.push_back(type);
+    this->data.push_back(data);
+    maxDuration = std::max(maxDuration, duration);
+    alive.push_back(true);
+    holding.push_back(false);
+    holdMissed.push_back(false);
+}
+
+std::pair<std::size_t, std::size_t> World::Beats::range(float from, float to) const
+{
+    // a beat can't end later than maxDuration after it starts
+    const auto first = std::lower_bound(start.begin(), start.end(), from - maxDuration);
+    const auto last = std::upper_bound(first, start.end(), to);
+    return { first - start.begin(), last - start.begin() };
+}
+
+World::Beats::State World::Beats::state(std::size_t index) const
+{
+    if (!alive[index])
+        return State::Inactive;
+    if (holding[index])
+        return State::Holding;
+    if (holdMissed[index])
+        return State::HoldMissed;
+    return State::Active;
+}
+
+void World::Beats::setState(std::size_t index, State state)
+{
+    alive[index] = state != State::Inactive;
+    holding[index] = state == State::Holding;
+    holdMissed[index] = state == State::HoldMissed;
 }
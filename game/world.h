@@ -1,22 +1,33 @@
 #pragma once
 
+#include "beatlane.h"
 #include "inputstate.h"
+#include "pathgenerator.h"
+#include "pathtable.h"
 
-#include <glm/gtx/quaternion.hpp>
+#include <boost/dynamic_bitset.hpp>
 
+#include <cstdint>
 #include <memory>
+#include <utility>
 #include <vector>
 
 class ShaderManager;
 class Camera;
 class Renderer;
+class SceneFramebuffer;
+class TransparencyPass;
 class Mesh;
+class MeshArena;
+class InstanceCuller;
 struct Track;
 class HUDPainter;
 class HUDAnimation;
 class ComboCounter;
 class OggPlayer;
 class ParticleSystem;
+class DebrisSystem;
+class PathRibbons;
 
 class World
 {
@@ -34,83 +45,84 @@ public:
     void startGame();
     bool isPlaying() const;
 
+    void toggleParticleBillboardMode();
+
 private:
     void initializeLevel();
-    void initializeTrackMesh();
+    void resetTrack(unsigned seed);
+    void extendTrack(float distance);
+    void retireTrack(float distance);
     void initializeBeatMeshes();
     void initializeMarkerMesh();
     void initializeButtonMesh();
-    struct PathState {
-        glm::mat3 orientation;
-        glm::vec3 center;
-
-        glm::vec3 up() const { return orientation[0]; }
-        glm::vec3 side() const { return orientation[1]; }
-        glm::vec3 direction() const { return orientation[2]; }
-        glm::mat4 transformMatrix() const;
-    };
-    PathState pathStateAt(float distance) const;
     void updateCamera(bool snapToPosition);
     void updateBeats(InputState inputState);
-    void updateDebris(float elapsed);
+    void placeBeats();
     void updateTextAnimations(float elapsed);
     void updateComboPainter(float elapsed);
     void updateParticles(float elapsed);
+    void updateCullStats(float elapsed);
 
     ShaderManager *m_shaderManager;
     std::unique_ptr<Camera> m_camera;
+    std::unique_ptr<SceneFramebuffer> m_sceneFramebuffer;
+    std::unique_ptr<TransparencyPass> m_transparencyPass;
     std::unique_ptr<Renderer> m_renderer;
     std::unique_ptr<ParticleSystem> m_particleSystem;
-    struct TrackSegment {
-        glm::vec3 position;
-        std::unique_ptr<Mesh> mesh;
-    };
-    std::vector<TrackSegment> m_trackSegments;
-    struct PathPart {
-        PathState state;
-        float distance;
-    };
-    std::vector<PathPart> m_pathParts;
+    // only the window of the path around the camera is kept, see extendTrack and retireTrack
+    PathGenerator m_pathGenerator;
+    PathTable m_path;
+    PathTable::Cursor m_cameraPathCursor { &m_path };
+    PathTable::Cursor m_beatPathCursor { &m_path };
+    // the track is ribbon 0, followed by the hold note bodies grouped by lane, see initializeLevel
+    std::unique_ptr<PathRibbons> m_pathRibbons;
+    std::size_t m_nextBeatToPlace = 0; // first beat not yet placed on the path, see placeBeats
+    std::unique_ptr<MeshArena> m_meshArena; // for the meshes below, so they're drawn with few binds
     std::unique_ptr<Mesh> m_beatMesh;
     std::unique_ptr<Mesh> m_markerMesh;
     std::unique_ptr<Mesh> m_buttonMesh;
+    // tap notes, culled and drawn from the GPU; grouped by lane, see initializeLevel
+    std::unique_ptr<InstanceCuller> m_tapCuller;
+    std::unique_ptr<DebrisSystem> m_debrisSystem;
     float m_trackTime = 0.0f;
+    float m_cullStatsTime = 0.0f;
     const Track *m_track;
-    struct Beat {
-        enum class Type {
+    struct Beats {
+        enum class Type : std::uint8_t {
             Tap,
             Hold,
         };
-        Type type;
-        float start;
-        float duration;
-        int track;
-        glm::mat4 transform;
         enum class State {
             Active,
             Inactive,
             Holding,
             HoldMissed,
         };
-        State state;
-        std::unique_ptr<Mesh> mesh; // if type == Hold
-    };
-    struct Debris {
-        int track;
-        glm::vec3 position;
-        glm::mat3 orientation;
-        glm::vec3 scale;
-        glm::vec3 velocity;
-        glm::vec3 rotationAxis;
-        float angularSpeed;
-        float time;
-        float life;
+
+        std::size_t size() const { return start.size(); }
+        void clear();
+        void add(Type type, int track, float start, float duration, unsigned data);
+        State state(std::size_t index) const;
+        void setState(std::size_t index, State state);
+        // beats in [first, last) are the only ones that can overlap the time interval [from, to]
+        std::pair<std::size_t, std::size_t> range(float from, float to) const;
+
+        // indexed by beat, beats are sorted by start time
+        std::vector<float> start;
+        std::vector<float> duration;
+        std::vector<std::uint8_t> track;
+        std::vector<Type> type;
+        std::vector<unsigned> data; // instance in m_tapCuller if type == Tap, path ribbon if type == Hold
+        float maxDuration = 0.0f;
+        boost::dynamic_bitset<> alive; // state != Inactive
+        boost::dynamic_bitset<> holding; // state == Holding
+        boost::dynamic_bitset<> holdMissed; // state == HoldMissed
     };
     glm::vec3 m_cameraPosition;
     glm::mat4 m_markerTransform;
     glm::vec4 m_clipPlane; // to clip long notes
-    std::vector<std::unique_ptr<Beat>> m_beats;
-    std::vector<Debris> m_debris;
+    Beats m_beats;
+    std::vector<BeatLane> m_lanes; // indices into m_beats
     std::vector<std::unique_ptr<HUDAnimation>> m_hudAnimations;
     std::unique_ptr<ComboCounter> m_comboCounter;
     std::unique_ptr<OggPlayer> m_player;
@@ -1,6 +1,5 @@
 #include <gx/fontcache.h>
 
-#include <gx/ioutil.h>
 #include <gx/pixmap.h>
 
 #include <spdlog/spdlog.h>
@@ -16,13 +15,13 @@ FontCache::~FontCache() = default;
 
 bool FontCache::load(const std::string &ttfPath, int pixelHeight)
 {
-    auto buffer = Util::readFile(ttfPath);
-    if (!buffer)
+    VFS::File file(ttfPath);
+    if (!file)
         return false;
 
-    m_ttfBuffer = std::move(*buffer);
+    m_ttfFile = std::move(file);
 
-    int result = stbtt_InitFont(&m_font, m_ttfBuffer.data(), stbtt_GetFontOffsetForIndex(m_ttfBuffer.data(), 0));
+    int result = stbtt_InitFont(&m_font, m_ttfFile.data(), stbtt_GetFontOffsetForIndex(m_ttfFile.data(), 0));
     if (result == 0) {
         return false;
     }
@@ -2,6 +2,7 @@
 
 #include "textureatlas.h"
 #include "util.h"
+#include "vfs.h"
 
 #include <glm/glm.hpp>
 #include <stb_truetype.h>
@@ -33,7 +34,7 @@ private:
     std::unique_ptr<Glyph> initializeGlyph(int codepoint);
     Pixmap getCodepointPixmap(int codepoint) const;
 
-    std::vector<unsigned char> m_ttfBuffer;
+    VFS::File m_ttfFile;
     stbtt_fontinfo m_font;
     TextureAtlas *m_textureAtlas;
     std::unordered_map<int, std::unique_ptr<Glyph>> m_glyphs;
@@ -110,7 +110,7 @@ bool GLWindow::initialize(int width, int height, const char *title)
     });
 
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 2);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
     glfwWindowHint(GLFW_SAMPLES, 16);
     m_window = glfwCreateWindow(width, height, title, nullptr, nullptr);
@@ -130,8 +130,8 @@ bool GLWindow::initialize(int width, int height, const char *title)
         return false;
     }
 
-    if (!glewIsSupported("GL_VERSION_4_2")) {
-        spdlog::error("OpenGL 4.2 not supported");
+    if (!glewIsSupported("GL_VERSION_4_3")) {
+        spdlog::error("OpenGL 4.3 not supported");
         return false;
     }
 
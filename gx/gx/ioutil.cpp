@@ -1,26 +1,122 @@
 #include <gx/ioutil.h>
 
-#include <fstream>
+#include <algorithm>
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 namespace GX {
 namespace Util {
 
-std::optional<std::vector<unsigned char>> readFile(const std::string &path)
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::string &path)
 {
-    std::ifstream file(path, std::ios::binary);
-    if (!file.is_open())
-        return {};
+    auto file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return;
+
+    LARGE_INTEGER size;
+    if (GetFileSizeEx(file, &size)) {
+        m_size = static_cast<std::size_t>(size.QuadPart);
+        if (m_size == 0) {
+            m_isOpen = true;
+        } else if (auto mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr)) {
+            // the view keeps the mapping alive
+            m_data = static_cast<const unsigned char *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+            m_isOpen = m_data != nullptr;
+            CloseHandle(mapping);
+        }
+    }
+    CloseHandle(file);
+
+    if (!m_isOpen)
+        m_size = 0;
+}
+
+void MappedFile::unmap()
+{
+    if (m_data)
+        UnmapViewOfFile(m_data);
+}
+
+#else
+
+MappedFile::MappedFile(const std::string &path)
+{
+    const auto fd = open(path.c_str(), O_RDONLY);
+    if (fd == -1)
+        return;
+
+    struct stat status;
+    if (fstat(fd, &status) == 0 && S_ISREG(status.st_mode)) {
+        m_size = status.st_size;
+        if (m_size == 0) {
+            m_isOpen = true; // mmap refuses empty mappings
+        } else {
+            // the mapping doesn't need the descriptor to stay open
+            auto *data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data != MAP_FAILED) {
+                m_data = static_cast<const unsigned char *>(data);
+                m_isOpen = true;
+            }
+        }
+    }
+    close(fd);
+
+    if (!m_isOpen)
+        m_size = 0;
+}
+
+void MappedFile::unmap()
+{
+    if (m_data)
+        munmap(const_cast<unsigned char *>(m_data), m_size);
+}
 
-    auto *buf = file.rdbuf();
+#endif
 
-    const std::size_t size = buf->pubseekoff(0, file.end, file.in);
-    buf->pubseekpos(0, file.in);
+MappedFile::~MappedFile()
+{
+    unmap();
+}
 
-    std::vector<unsigned char> data(size + 1);
-    buf->sgetn(reinterpret_cast<char *>(data.data()), size);
-    data[size] = 0;
+MappedFile::MappedFile(MappedFile &&other)
+    : m_data(std::exchange(other.m_data, nullptr))
+    , m_size(std::exchange(other.m_size, 0))
+    , m_isOpen(std::exchange(other.m_isOpen, false))
+{
+}
+
+MappedFile &MappedFile::operator=(MappedFile &&other)
+{
+    if (this != &other) {
+        unmap();
+        m_data = std::exchange(other.m_data, nullptr);
+        m_size = std::exchange(other.m_size, 0);
+        m_isOpen = std::exchange(other.m_isOpen, false);
+    }
+    return *this;
+}
+
+std::optional<std::vector<unsigned char>> readFile(const std::string &path)
+{
+    const MappedFile file(path);
+    if (!file)
+        return {};
 
-    file.close();
+    std::vector<unsigned char> data(file.size() + 1);
+    std::copy(file.data(), file.data() + file.size(), data.begin());
+    data[file.size()] = 0;
 
     return data;
 }
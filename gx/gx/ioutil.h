@@ -1,12 +1,59 @@
 #pragma once
 
+#include "noncopyable.h"
+
+#include <cstddef>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace GX {
 namespace Util {
 
+// A whole file mapped read-only into memory: pages are read in as they're first touched and
+// nothing is copied, so it's the way to go for data that's only read. The mapping stays valid
+// as long as the object, and across moves.
+class MappedFile : private NonCopyable
+{
+public:
+    MappedFile() = default;
+    explicit MappedFile(const std::string &path);
+    ~MappedFile();
+
+    MappedFile(MappedFile &&other);
+    MappedFile &operator=(MappedFile &&other);
+
+    explicit operator bool() const
+    {
+        return m_isOpen;
+    }
+
+    const unsigned char *data() const
+    {
+        return m_data;
+    }
+
+    std::size_t size() const
+    {
+        return m_size;
+    }
+
+    std::string_view text() const
+    {
+        return { reinterpret_cast<const char *>(m_data), m_size };
+    }
+
+private:
+    void unmap();
+
+    const unsigned char *m_data = nullptr; // null for empty files
+    std::size_t m_size = 0;
+    bool m_isOpen = false;
+};
+
+// A copy of the file with a null byte appended, for callers that need to modify the data or want a
+// C string.
 std::optional<std::vector<unsigned char>> readFile(const std::string &path);
 
 }
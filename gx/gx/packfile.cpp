@@ -0,0 +1,154 @@
+#include <gx/packfile.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <type_traits>
+
+namespace GX {
+
+namespace {
+
+constexpr char Magic[4] = { 'P', 'A', 'C', 'K' };
+constexpr std::uint32_t Version = 2; // bump whenever the layout below changes
+constexpr std::size_t ContentsAlignment = 64;
+
+struct Header {
+    char magic[4];
+    std::uint32_t version;
+    std::uint32_t entryCount;
+    std::uint32_t reserved;
+};
+
+// FNV-1a
+std::uint64_t nameHash(std::string_view name)
+{
+    std::uint64_t hash = 0xcbf29ce484222325;
+    for (const auto c : name) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 0x100000001b3;
+    }
+    return hash;
+}
+
+std::uint64_t aligned(std::uint64_t offset)
+{
+    return (offset + ContentsAlignment - 1) / ContentsAlignment * ContentsAlignment;
+}
+
+} // namespace
+
+struct PackFile::Entry {
+    std::uint64_t hash;
+    std::uint64_t offset; // from the start of the file
+    std::uint64_t size;
+    std::uint32_t nameOffset; // from the end of the index
+    std::uint32_t nameSize;
+    std::int64_t sourceTime; // nanoseconds since the file clock's epoch
+};
+
+PackFile::PackFile(const std::string &path)
+    : m_file(path)
+{
+    static_assert(sizeof(Entry) == 40 && std::is_trivially_copyable_v<Entry>, "unexpected Entry layout");
+
+    if (!m_file || m_file.size() < sizeof(Header))
+        return;
+
+    Header header;
+    std::memcpy(&header, m_file.data(), sizeof(header));
+    if (std::memcmp(header.magic, Magic, sizeof(Magic)) != 0 || header.version != Version)
+        return;
+    if ((m_file.size() - sizeof(Header)) / sizeof(Entry) < header.entryCount)
+        return;
+
+    // the mapping is page aligned, and so is the index right after the header
+    const auto *entries = reinterpret_cast<const Entry *>(m_file.data() + sizeof(Header));
+    const auto namesOffset = sizeof(Header) + header.entryCount * sizeof(Entry);
+    const auto fitsInFile = [this](std::uint64_t offset, std::uint64_t size) {
+        return offset <= m_file.size() && size <= m_file.size() - offset;
+    };
+    for (std::size_t i = 0; i < header.entryCount; ++i) {
+        const auto &entry = entries[i];
+        if (!fitsInFile(entry.offset, entry.size) || !fitsInFile(namesOffset + entry.nameOffset, entry.nameSize))
+            return;
+    }
+
+    m_entries = entries;
+    m_entryCount = header.entryCount;
+}
+
+std::optional<PackFile::Contents> PackFile::find(std::string_view name) const
+{
+    const auto hash = nameHash(name);
+    const auto *names = reinterpret_cast<const char *>(m_file.data()) + sizeof(Header) + m_entryCount * sizeof(Entry);
+    auto it = std::lower_bound(m_entries, m_entries + m_entryCount, hash, [](const Entry &entry, std::uint64_t hash) {
+        return entry.hash < hash;
+    });
+    for (; it != m_entries + m_entryCount && it->hash == hash; ++it) {
+        if (std::string_view(names + it->nameOffset, it->nameSize) == name) {
+            const auto sourceTime = std::chrono::duration_cast<std::filesystem::file_time_type::duration>(std::chrono::nanoseconds(it->sourceTime));
+            return Contents { m_file.data() + it->offset, static_cast<std::size_t>(it->size), std::filesystem::file_time_type(sourceTime) };
+        }
+    }
+    return {};
+}
+
+bool PackFile::write(const std::string &path, const std::vector<Source> &sources)
+{
+    std::vector<Util::MappedFile> files;
+    files.reserve(sources.size());
+    for (const auto &source : sources) {
+        files.emplace_back(source.path);
+        if (!files.back())
+            return false;
+    }
+
+    std::vector<Entry> entries(sources.size());
+    std::string names;
+    for (std::size_t i = 0; i < sources.size(); ++i) {
+        auto &entry = entries[i];
+        entry.hash = nameHash(sources[i].name);
+        entry.size = files[i].size();
+        entry.nameOffset = names.size();
+        entry.nameSize = sources[i].name.size();
+        std::error_code error;
+        const auto sourceTime = std::filesystem::last_write_time(sources[i].path, error);
+        entry.sourceTime = error ? std::numeric_limits<std::int64_t>::min() : std::chrono::duration_cast<std::chrono::nanoseconds>(sourceTime.time_since_epoch()).count();
+        names += sources[i].name;
+    }
+
+    // contents go in the order they were given, the index is sorted for lookups
+    auto offset = sizeof(Header) + entries.size() * sizeof(Entry) + names.size();
+    for (auto &entry : entries) {
+        offset = aligned(offset);
+        entry.offset = offset;
+        offset += entry.size;
+    }
+    std::vector<std::size_t> order(entries.size());
+    for (std::size_t i = 0; i < order.size(); ++i)
+        order[i] = i;
+    std::sort(order.begin(), order.end(), [&entries](std::size_t lhs, std::size_t rhs) {
+        return entries[lhs].hash < entries[rhs].hash;
+    });
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    Header header = {};
+    std::memcpy(header.magic, Magic, sizeof(Magic));
+    header.version = Version;
+    header.entryCount = entries.size();
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    for (const auto i : order)
+        file.write(reinterpret_cast<const char *>(&entries[i]), sizeof(Entry));
+    file.write(names.data(), names.size());
+    for (std::size_t i = 0; i < entries.size(); ++i) {
+        const std::string padding(entries[i].offset - static_cast<std::uint64_t>(file.tellp()), '\0');
+        file.write(padding.data(), padding.size());
+        file.write(reinterpret_cast<const char *>(files[i].data()), files[i].size());
+    }
+    return file.good();
+}
+
+} // namespace GX
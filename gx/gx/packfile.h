@@ -0,0 +1,55 @@
+#pragma once
+
+#include "ioutil.h"
+#include "noncopyable.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace GX {
+
+// Many files in one: a header, an index of entries sorted by the hash of their name, the names, then
+// the contents of each file at an aligned offset. Opening it is mapping a single file, after which
+// finding an entry is a binary search over the index. The data is in native byte order.
+class PackFile : private NonCopyable
+{
+public:
+    explicit PackFile(const std::string &path);
+
+    explicit operator bool() const
+    {
+        return m_entries != nullptr;
+    }
+
+    std::size_t entryCount() const
+    {
+        return m_entryCount;
+    }
+
+    struct Contents {
+        const unsigned char *data;
+        std::size_t size;
+        std::filesystem::file_time_type sourceTime; // last write time of the file it was packed from
+    };
+    std::optional<Contents> find(std::string_view name) const;
+
+    struct Source {
+        std::string name;
+        std::string path;
+    };
+    static bool write(const std::string &path, const std::vector<Source> &sources);
+
+private:
+    struct Entry;
+
+    Util::MappedFile m_file;
+    const Entry *m_entries = nullptr;
+    std::size_t m_entryCount = 0;
+};
+
+} // namespace GX
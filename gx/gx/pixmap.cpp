@@ -1,5 +1,7 @@
 #include <gx/pixmap.h>
 
+#include <gx/vfs.h>
+
 #include <stb_image.h>
 
 #include <cassert>
@@ -10,8 +12,12 @@ Pixmap loadPixmap(const std::string &path)
 {
     stbi_set_flip_vertically_on_load(1);
 
+    const VFS::File file(path);
+    if (!file)
+        return {};
+
     int width, height, channels;
-    unsigned char *data = stbi_load(path.c_str(), &width, &height, &channels, 4);
+    unsigned char *data = stbi_load_from_memory(file.data(), static_cast<int>(file.size()), &width, &height, &channels, 4);
     if (!data)
         return {};
     assert(channels == 4);
@@ -1,5 +1,5 @@
-#include <gx/ioutil.h>
 #include <gx/shaderprogram.h>
+#include <gx/vfs.h>
 
 #include <array>
 #include <fstream>
@@ -24,15 +24,16 @@ ShaderProgram::~ShaderProgram()
 
 bool ShaderProgram::addShader(GLenum type, const std::string &filename)
 {
-    const auto source = Util::readFile(filename);
-    if (!source) {
+    const VFS::File file(filename);
+    if (!file) {
         std::stringstream ss;
         ss << "Failed to load " << filename;
         m_log = ss.str();
         return false;
     }
 
-    return addShaderSource(type, reinterpret_cast<const GLchar *>(source->data()));
+    const std::string source(file.text()); // null terminated
+    return addShaderSource(type, source.c_str());
 }
 
 bool ShaderProgram::addShaderSource(GLenum type, const GLchar *sourcePtr)
@@ -0,0 +1,85 @@
+#include <gx/vfs.h>
+
+#include <gx/packfile.h>
+
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <system_error>
+#include <utility>
+
+namespace GX {
+namespace VFS {
+
+namespace {
+
+std::unique_ptr<PackFile> mountedPack;
+std::string mountPoint; // the directory with a trailing separator
+
+std::optional<PackFile::Contents> findPacked(const std::string &path)
+{
+    if (!mountedPack || path.compare(0, mountPoint.size(), mountPoint) != 0)
+        return {};
+    auto contents = mountedPack->find(std::string_view(path).substr(mountPoint.size()));
+    if (!contents)
+        return {};
+    // A loose file edited since it was packed wins, so changes show up without rebuilding the pack.
+    std::error_code error;
+    const auto looseTime = std::filesystem::last_write_time(path, error);
+    if (!error && looseTime > contents->sourceTime)
+        return {};
+    return contents;
+}
+
+} // namespace
+
+bool mount(const std::string &packPath, const std::string &directory)
+{
+    auto pack = std::make_unique<PackFile>(packPath);
+    if (!*pack)
+        return false;
+    mountedPack = std::move(pack);
+    mountPoint = directory + '/';
+    return true;
+}
+
+bool isPacked(const std::string &path)
+{
+    return findPacked(path).has_value();
+}
+
+File::File(const std::string &path)
+{
+    if (const auto contents = findPacked(path)) {
+        m_data = contents->data;
+        m_size = contents->size;
+        m_isOpen = true;
+        return;
+    }
+    m_file = Util::MappedFile(path);
+    m_data = m_file.data();
+    m_size = m_file.size();
+    m_isOpen = static_cast<bool>(m_file);
+}
+
+File::File(File &&other)
+    : m_file(std::move(other.m_file))
+    , m_data(std::exchange(other.m_data, nullptr))
+    , m_size(std::exchange(other.m_size, 0))
+    , m_isOpen(std::exchange(other.m_isOpen, false))
+{
+}
+
+File &File::operator=(File &&other)
+{
+    if (this != &other) {
+        m_file = std::move(other.m_file);
+        m_data = std::exchange(other.m_data, nullptr);
+        m_size = std::exchange(other.m_size, 0);
+        m_isOpen = std::exchange(other.m_isOpen, false);
+    }
+    return *this;
+}
+
+}
+} // namespace GX
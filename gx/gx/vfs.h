@@ -0,0 +1,59 @@
+#pragma once
+
+#include "ioutil.h"
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace GX {
+namespace VFS {
+
+// Mounts a pack file (see packfile.h) over a directory, once at startup: files under the directory
+// are then read from the pack if it has them, the names in the pack being relative to the
+// directory, and from the directory otherwise. A loose file newer than the one its packed copy was
+// made from is read from the directory too. Returns false if the pack couldn't be opened, in
+// which case everything is read from the directory as before.
+bool mount(const std::string &packPath, const std::string &directory);
+
+bool isPacked(const std::string &path);
+
+// The contents of a file, either a slice of the mounted pack or the file mapped on its own.
+class File
+{
+public:
+    File() = default;
+    explicit File(const std::string &path);
+
+    File(File &&other);
+    File &operator=(File &&other);
+
+    explicit operator bool() const
+    {
+        return m_isOpen;
+    }
+
+    const unsigned char *data() const
+    {
+        return m_data;
+    }
+
+    std::size_t size() const
+    {
+        return m_size;
+    }
+
+    std::string_view text() const
+    {
+        return { reinterpret_cast<const char *>(m_data), m_size };
+    }
+
+private:
+    Util::MappedFile m_file; // only for files that aren't packed
+    const unsigned char *m_data = nullptr;
+    std::size_t m_size = 0;
+    bool m_isOpen = false;
+};
+
+}
+} // namespace GX
@@ -0,0 +1,73 @@
+#include <gx/ioutil.h>
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <utility>
+
+using namespace std::string_literals;
+
+namespace {
+
+bool writeFile(const std::string &path, const std::string &contents)
+{
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file << contents;
+    return file.good();
+}
+
+} // namespace
+
+int main()
+{
+    const auto path = "tst_mappedfile.dat"s;
+    std::string contents;
+    for (int i = 0; i < 100000; ++i) // a few pages
+        contents += std::to_string(i) + '\n';
+    if (!writeFile(path, contents)) {
+        std::cout << "Failed to write " << path << '\n';
+        return 1;
+    }
+
+    GX::Util::MappedFile file(path);
+    if (!file || file.text() != contents) {
+        std::cout << "Mapped contents differ\n";
+        return 1;
+    }
+
+    const auto copy = GX::Util::readFile(path);
+    if (!copy || copy->size() != contents.size() + 1 || copy->back() != 0 || std::string(copy->begin(), copy->end() - 1) != contents) {
+        std::cout << "readFile contents differ\n";
+        return 1;
+    }
+
+    // the mapping moves along with the object
+    const auto *data = file.data();
+    auto moved = std::move(file);
+    if (file || file.size() != 0 || moved.data() != data || moved.text() != contents) {
+        std::cout << "Move didn't transfer the mapping\n";
+        return 1;
+    }
+    moved = GX::Util::MappedFile();
+    if (moved) {
+        std::cout << "Assigning an empty file didn't unmap\n";
+        return 1;
+    }
+
+    if (!writeFile(path, {})) {
+        std::cout << "Failed to truncate " << path << '\n';
+        return 1;
+    }
+    const GX::Util::MappedFile empty(path);
+    if (!empty || empty.size() != 0) {
+        std::cout << "Empty file didn't open\n";
+        return 1;
+    }
+    std::remove(path.c_str());
+
+    if (GX::Util::MappedFile("no such file"s)) {
+        std::cout << "Missing file opened\n";
+        return 1;
+    }
+}
@@ -0,0 +1,132 @@
+#include <gx/packfile.h>
+#include <gx/vfs.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std::string_literals;
+
+// Packs a few files, then reads them back through the VFS along with a file that's only on disk and
+// loose copies of packed files, edited before and after packing.
+
+namespace {
+
+bool writeFile(const std::string &path, const std::string &contents)
+{
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file << contents;
+    return file.good();
+}
+
+} // namespace
+
+int main()
+{
+    const auto packPath = "tst_packfile.pack"s;
+    std::vector<GX::PackFile::Source> sources;
+    std::vector<std::string> contents;
+    for (int i = 0; i < 100; ++i) {
+        const auto path = "tst_packfile" + std::to_string(i) + ".dat";
+        contents.push_back(std::string(i * 37, static_cast<char>('a' + i % 26)));
+        if (!writeFile(path, contents.back())) {
+            std::cout << "Failed to write " << path << '\n';
+            return 1;
+        }
+        sources.push_back({ "files/" + std::to_string(i), path });
+    }
+    const auto written = GX::PackFile::write(packPath, sources);
+    for (const auto &source : sources)
+        std::remove(source.path.c_str());
+    if (!written) {
+        std::cout << "Failed to write " << packPath << '\n';
+        return 1;
+    }
+
+    {
+        const GX::PackFile pack(packPath);
+        if (!pack || pack.entryCount() != sources.size()) {
+            std::cout << "Failed to open " << packPath << '\n';
+            return 1;
+        }
+        for (std::size_t i = 0; i < sources.size(); ++i) {
+            const auto entry = pack.find(sources[i].name);
+            if (!entry || std::string(reinterpret_cast<const char *>(entry->data), entry->size) != contents[i]) {
+                std::cout << "Wrong contents for " << sources[i].name << '\n';
+                return 1;
+            }
+            if (reinterpret_cast<std::uintptr_t>(entry->data) % 64 != 0) {
+                std::cout << sources[i].name << " isn't aligned\n";
+                return 1;
+            }
+        }
+        if (pack.find("files/100")) {
+            std::cout << "Found a file that wasn't packed\n";
+            return 1;
+        }
+    }
+
+    const auto mountPoint = "tst_packfile_assets"s;
+    if (!GX::VFS::mount(packPath, mountPoint)) {
+        std::cout << "Failed to mount " << packPath << '\n';
+        return 1;
+    }
+    const GX::VFS::File packed(mountPoint + "/files/42");
+    if (!packed || !GX::VFS::isPacked(mountPoint + "/files/42") || packed.text() != contents[42]) {
+        std::cout << "Wrong contents for a packed file\n";
+        return 1;
+    }
+    if (GX::VFS::isPacked("files/42"s)) {
+        std::cout << "Found a packed file outside the mount point\n";
+        return 1;
+    }
+
+    // not packed, so read from disk
+    const auto loosePath = "tst_packfile.loose"s;
+    if (!writeFile(loosePath, "loose"s)) {
+        std::cout << "Failed to write " << loosePath << '\n';
+        return 1;
+    }
+    auto loose = GX::VFS::File(loosePath);
+    std::remove(loosePath.c_str());
+    if (!loose || GX::VFS::isPacked(loosePath) || loose.text() != "loose") {
+        std::cout << "Wrong contents for a loose file\n";
+        return 1;
+    }
+    if (GX::VFS::File(mountPoint + "/files/100")) {
+        std::cout << "Opened a file that doesn't exist\n";
+        return 1;
+    }
+
+    // loose copies of packed files are only read if they were edited after packing
+    std::filesystem::create_directories(mountPoint + "/files");
+    const auto newerPath = mountPoint + "/files/42";
+    const auto olderPath = mountPoint + "/files/43";
+    if (!writeFile(newerPath, "newer"s) || !writeFile(olderPath, "older"s)) {
+        std::cout << "Failed to write the loose copies\n";
+        return 1;
+    }
+    const auto now = std::filesystem::file_time_type::clock::now();
+    std::filesystem::last_write_time(newerPath, now + std::chrono::hours(1));
+    std::filesystem::last_write_time(olderPath, now - std::chrono::hours(1));
+    const GX::VFS::File newer(newerPath);
+    const GX::VFS::File older(olderPath);
+    const auto newerPacked = GX::VFS::isPacked(newerPath);
+    const auto olderPacked = GX::VFS::isPacked(olderPath);
+    std::filesystem::remove_all(mountPoint);
+    if (!newer || newerPacked || newer.text() != "newer") {
+        std::cout << "Read a packed file instead of its newer loose copy\n";
+        return 1;
+    }
+    if (!older || !olderPacked || older.text() != contents[43]) {
+        std::cout << "Read a loose copy older than its packed file\n";
+        return 1;
+    }
+
+    std::remove(packPath.c_str());
+}
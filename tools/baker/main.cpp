@@ -0,0 +1,182 @@
+#include <bakedassets.h>
+#include <track.h>
+
+#include <gx/packfile.h>
+#include <gx/pixmap.h>
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <vector>
+
+// Converts the game's assets into the files bakedassets.h describes:
+//
+//     baker [--force] [--output directory] [--pack pack file] [assets directory]
+//
+// The baked files go to the output directory, laid out like the assets directory, or next to their
+// sources without one. Assets whose baked file is already current are skipped unless
+// --force is given. With --pack, the assets then go into a pack file (see gx/packfile.h) along with
+// the baked files, which take the place of their sources, all named relative to their directory as
+// the game finds them under the assets directory; it's only rewritten if something changed.
+
+namespace {
+
+bool bakeMesh(const std::string &path, const std::string &bakedFile)
+{
+    const auto model = loadObjModel(path);
+    return model && writeBakedMesh(path, bakedFile, *model, GameVertexFormat);
+}
+
+bool bakeTexture(const std::string &path, const std::string &bakedFile)
+{
+    const auto pixmap = GX::loadPixmap(path);
+    if (!pixmap)
+        return false;
+    return writeBakedTexture(path, bakedFile, pixmap);
+}
+
+bool bakeTrack(const std::string &path, const std::string &bakedFile)
+{
+    const auto track = loadTrackJson(path);
+    if (!track)
+        return false;
+    return writeBakedTrack(path, bakedFile, *track);
+}
+
+// where the baked file for the asset at path goes, its bakedPath moved from assets to output
+std::filesystem::path outputPath(const std::filesystem::path &path, const std::filesystem::path &assets, const std::filesystem::path &output)
+{
+    auto relativePath = path.lexically_relative(assets);
+    relativePath += ".baked";
+    return output / relativePath;
+}
+
+// adds the regular files under directory that include accepts, named relative to it
+bool addFiles(std::vector<GX::PackFile::Source> &sources, std::filesystem::file_time_type &newest, const std::filesystem::path &directory,
+    const std::function<bool(const std::filesystem::path &)> &include)
+{
+    std::error_code error;
+    for (const auto &entry : std::filesystem::recursive_directory_iterator(directory, error)) {
+        newest = std::max(newest, entry.last_write_time()); // directories included, for removed files
+        if (entry.is_regular_file() && include(entry.path()))
+            sources.push_back({ entry.path().lexically_relative(directory).generic_string(), entry.path().generic_string() });
+    }
+    if (error) {
+        spdlog::error("Can't read {}: {}", directory.generic_string(), error.message());
+        return false;
+    }
+    return true;
+}
+
+bool writePack(const std::filesystem::path &packPath, const std::filesystem::path &assets, const std::filesystem::path &output, bool force)
+{
+    std::vector<GX::PackFile::Source> sources;
+    auto newest = std::filesystem::file_time_type::min();
+    const auto isUnbakedSource = [&](const std::filesystem::path &path) {
+        const auto extension = path.extension();
+        if (extension == ".pack" || extension == ".baked") // a baked file left in the assets might be stale
+            return false;
+        return !std::filesystem::exists(outputPath(path, assets, output)); // the game reads the baked file instead
+    };
+    const auto isBakedFile = [](const std::filesystem::path &path) {
+        return path.extension() == ".baked";
+    };
+    if (!addFiles(sources, newest, assets, isUnbakedSource))
+        return false;
+    if (std::filesystem::exists(output) && !addFiles(sources, newest, output, isBakedFile))
+        return false;
+
+    std::error_code error;
+    const auto packTime = std::filesystem::last_write_time(packPath, error);
+    if (!force && !error && packTime >= newest) {
+        // touched all the same, for the build that ran the baker because something it depends on
+        // changed and expects a newer pack
+        std::filesystem::last_write_time(packPath, std::filesystem::file_time_type::clock::now(), error);
+        spdlog::info("{} is already current", packPath.generic_string());
+        return true;
+    }
+
+    std::sort(sources.begin(), sources.end(), [](const auto &lhs, const auto &rhs) {
+        return lhs.name < rhs.name;
+    });
+    if (!GX::PackFile::write(packPath.string(), sources)) {
+        spdlog::error("Failed to write {}", packPath.generic_string());
+        return false;
+    }
+    spdlog::info("Packed {} files into {}", sources.size(), packPath.generic_string());
+    return true;
+}
+
+struct Bakery {
+    const char *directory;
+    const char *extension;
+    std::function<bool(const std::string &, const std::string &)> bake;
+};
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    bool force = false;
+    std::filesystem::path assets = "assets";
+    std::filesystem::path output;
+    std::filesystem::path packPath;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--force") == 0)
+            force = true;
+        else if (std::strcmp(argv[i], "--output") == 0 && i + 1 < argc)
+            output = argv[++i];
+        else if (std::strcmp(argv[i], "--pack") == 0 && i + 1 < argc)
+            packPath = argv[++i];
+        else
+            assets = argv[i];
+    }
+    if (output.empty())
+        output = assets;
+
+    const Bakery bakeries[] = {
+        { "meshes", ".obj", bakeMesh },
+        { "textures", ".png", bakeTexture },
+        { "tracks", ".json", bakeTrack },
+    };
+
+    int baked = 0, current = 0, failed = 0;
+    for (const auto &bakery : bakeries) {
+        std::error_code error;
+        for (const auto &entry : std::filesystem::directory_iterator(assets / bakery.directory, error)) {
+            if (!entry.is_regular_file() || entry.path().extension() != bakery.extension)
+                continue;
+            const auto path = entry.path().generic_string();
+            const auto bakedFile = outputPath(entry.path(), assets, output);
+            if (!force && isBakedFileCurrent(path, bakedFile.generic_string())) {
+                ++current;
+                continue;
+            }
+            const auto start = std::chrono::steady_clock::now();
+            std::error_code directoryError; // writing the baked file fails below if it's not there
+            std::filesystem::create_directories(bakedFile.parent_path(), directoryError);
+            if (!bakery.bake(path, bakedFile.generic_string())) {
+                spdlog::error("Failed to bake {}", path);
+                ++failed;
+                continue;
+            }
+            const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+            spdlog::info("Baked {} in {:.1f} ms", bakedFile.generic_string(), elapsed.count());
+            ++baked;
+        }
+        if (error)
+            spdlog::warn("Can't read {}: {}", (assets / bakery.directory).generic_string(), error.message());
+    }
+
+    spdlog::info("{} baked, {} already current, {} failed", baked, current, failed);
+    if (failed != 0)
+        return 1;
+
+    if (!packPath.empty() && !writePack(packPath, assets, output, force))
+        return 1;
+    return 0;
+}